@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+// Microbenchmark of the FQDN validator compared with the regular expression
+// used before.
+
+#include "arguments.hpp"
+#include "fqdn_regex.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+/**
+ * @brief Measure average time of the validator call.
+ *
+ * @param[in] fn validator function
+ * @param[in] name value to check
+ * @param[in] iterations number of iterations
+ *
+ * @return average time in nanoseconds
+ */
+template <typename F>
+static double measure(F fn, const std::string& name, size_t iterations)
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t valid = 0;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        valid += fn(name);
+    }
+    const auto end = Clock::now();
+
+    // Prevent the loop from being optimized out
+    if (valid != 0 && valid != iterations)
+    {
+        puts("Unstable result");
+    }
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           iterations;
+}
+
+/** @brief Application entry point. */
+int main()
+{
+    const std::string label63(63, 'a');
+
+    std::string labels127;
+    for (int i = 0; i < 127; ++i)
+    {
+        labels127 += i ? ".a" : "a";
+    }
+
+    std::string hyphens = "a";
+    hyphens.append(253, '-');
+    hyphens += '.';
+
+    // clang-format off
+    const std::pair<const char*, std::string> inputs[] = {
+        {"valid short", "ntp.example.com"},
+        {"valid 255 bytes", label63 + '.' + label63 + '.' + label63 + '.' + std::string(63, 'b')},
+        {"valid 127 labels", labels127},
+        {"invalid short", "foo_bar.com"},
+        {"invalid rightmost label", labels127.substr(0, 251) + ".1a"},
+        {"adversarial long label", std::string(255, 'a')},
+        {"adversarial hyphens", hyphens},
+        {"adversarial 128 labels", labels127 + ".a"},
+    };
+    // clang-format on
+
+    constexpr size_t iterations = 1000;
+
+    printf("%-26s %12s %12s %8s\n", "Input", "Regex, ns", "Matcher, ns",
+           "Ratio");
+    for (const auto& [title, name] : inputs)
+    {
+        const double regex = measure(isFQDNRegex, name, iterations);
+        const double matcher =
+            measure(Arguments::isFQDN, name, iterations * 100);
+        printf("%-26s %12.1f %12.1f %8.1f\n", title, regex, matcher,
+               regex / matcher);
+    }
+
+    return 0;
+}
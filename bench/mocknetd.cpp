@@ -0,0 +1,674 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+// Mock of the network and syslog configuration services, used to measure
+// netconfig performance without a real BMC.
+
+#include "dbus.hpp"
+#include "netconfig.hpp"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/server/interface.hpp>
+#include <sdbusplus/server/manager.hpp>
+#include <sdbusplus/vtable.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+class Service;
+
+/**
+ * @struct Object
+ * @brief Mock D-Bus object: set of interfaces with their properties.
+ */
+struct Object
+{
+    /** @brief Owning service. */
+    Service& service;
+    /** @brief Object path. */
+    std::string path;
+    /** @brief Interfaces and their properties. */
+    std::map<std::string, Dbus::Properties> interfaces;
+    /** @brief Registered D-Bus interfaces. */
+    std::vector<std::unique_ptr<sdbusplus::server::interface::interface>>
+        handles;
+};
+
+/**
+ * @class Service
+ * @brief Mock network service: registry of objects.
+ */
+class Service
+{
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] bus D-Bus connection
+     */
+    Service(sdbusplus::bus::bus& bus) :
+        bus(bus), manager(bus, Dbus::objectRoot), ipIndex(0)
+    {}
+
+    /**
+     * @brief Register new object.
+     *
+     * @param[in] path object path
+     * @param[in] interfaces interfaces and their properties
+     * @param[in] announce flag to emit InterfacesAdded signal
+     *
+     * @throw std::invalid_argument if object already exists
+     */
+    void add(const std::string& path,
+             std::map<std::string, Dbus::Properties>&& interfaces,
+             bool announce);
+
+    /**
+     * @brief Unregister the object and all its children.
+     *        Objects are destroyed later by collect() as the method handler
+     *        of the removed object can still be running.
+     *
+     * @param[in] path object path
+     */
+    void remove(const std::string& path);
+
+    /** @brief Destroy removed objects. */
+    void collect();
+
+    /**
+     * @brief Check if the object exists.
+     *
+     * @param[in] path object path
+     *
+     * @return true if object exists
+     */
+    bool exists(const std::string& path) const;
+
+    /**
+     * @brief Add Ethernet interface object.
+     *
+     * @param[in] name network interface name
+     * @param[in] vlan VLAN ID or 0 for physical interface
+     * @param[in] announce flag to emit InterfacesAdded signal
+     *
+     * @return path to the new object
+     */
+    std::string addInterface(const std::string& name, uint32_t vlan,
+                             bool announce);
+
+    /**
+     * @brief Add IP address object.
+     *
+     * @param[in] ethObject path to the Ethernet interface object
+     * @param[in] protocol IP protocol type
+     * @param[in] address IP address
+     * @param[in] prefix prefix length
+     * @param[in] gateway gateway address
+     * @param[in] announce flag to emit InterfacesAdded signal
+     *
+     * @return path to the new object
+     */
+    std::string addAddress(const std::string& ethObject,
+                           const std::string& protocol,
+                           const std::string& address, uint8_t prefix,
+                           const std::string& gateway, bool announce);
+
+  private:
+    /** @brief D-Bus connection. */
+    sdbusplus::bus::bus& bus;
+    /** @brief Object manager of the network objects. */
+    sdbusplus::server::manager::manager manager;
+    /** @brief Registered objects. */
+    std::map<std::string, std::unique_ptr<Object>> objects;
+    /** @brief Removed objects waiting for destruction. */
+    std::vector<std::unique_ptr<Object>> removed;
+    /** @brief Counter used to generate IP object names. */
+    size_t ipIndex;
+};
+
+/** @brief D-Bus error name for invalid arguments. */
+static const char* errInvalidArgument =
+    "xyz.openbmc_project.Common.Error.InvalidArgument";
+
+/** @brief Property getter: any property of the mock object. */
+static int getProperty(sd_bus*, const char*, const char* interface,
+                       const char* property, sd_bus_message* reply,
+                       void* context, sd_bus_error*)
+{
+    const auto* object = static_cast<const Object*>(context);
+    sdbusplus::message::message msg(reply);
+    std::visit([&msg](auto&& value) { msg.append(value); },
+               object->interfaces.at(interface).at(property));
+    return 1;
+}
+
+/** @brief Property setter: any property of the mock object. */
+static int setProperty(sd_bus* bus, const char* path, const char* interface,
+                       const char* property, sd_bus_message* value,
+                       void* context, sd_bus_error*)
+{
+    auto* object = static_cast<Object*>(context);
+    sdbusplus::message::message msg(value);
+    Dbus::PropertyValue& current =
+        object->interfaces.at(interface).at(property);
+    // New value has the same type as the current one (vtable signature)
+    std::visit(
+        [&msg, &current](auto&& old) {
+            std::decay_t<decltype(old)> val;
+            msg.read(val);
+            current = std::move(val);
+        },
+        current);
+    sd_bus_emit_properties_changed(bus, path, interface, property, nullptr);
+    return 1;
+}
+
+/** @brief Method handler: `IP.Create.IP(protocol, address, prefix, gw)`. */
+static int createIp(sd_bus_message* m, void* context, sd_bus_error* err)
+{
+    auto* object = static_cast<Object*>(context);
+    sdbusplus::message::message msg(m);
+    std::string protocol, address, gateway;
+    uint8_t prefix;
+    msg.read(protocol, address, prefix, gateway);
+    if (address.empty() || prefix > 128)
+    {
+        return sd_bus_error_set_const(err, errInvalidArgument,
+                                      "Invalid IP address");
+    }
+    const std::string path = object->service.addAddress(
+        object->path, protocol, address, prefix, gateway, true);
+    return sd_bus_reply_method_return(m, "o", path.c_str());
+}
+
+/** @brief Method handler: `VLAN.Create.VLAN(interface, id)`. */
+static int createVlan(sd_bus_message* m, void* context, sd_bus_error* err)
+{
+    auto* object = static_cast<Object*>(context);
+    sdbusplus::message::message msg(m);
+    std::string iface;
+    uint32_t id;
+    msg.read(iface, id);
+    if (!object->service.exists(Dbus::ethToPath(iface.c_str())) ||
+        object->service.exists(Dbus::ethToPath(iface.c_str()) + '_' +
+                               std::to_string(id)))
+    {
+        return sd_bus_error_set_const(err, errInvalidArgument,
+                                      "Invalid VLAN");
+    }
+    const std::string path = object->service.addInterface(iface, id, true);
+    return sd_bus_reply_method_return(m, "o", path.c_str());
+}
+
+/** @brief Method handler: `Delete.Delete()`. */
+static int deleteObject(sd_bus_message* m, void* context, sd_bus_error*)
+{
+    auto* object = static_cast<Object*>(context);
+    object->service.remove(object->path);
+    return sd_bus_reply_method_return(m, "");
+}
+
+/** @brief Method handler: `FactoryReset.Reset()`. */
+static int reset(sd_bus_message* m, void*, sd_bus_error*)
+{
+    return sd_bus_reply_method_return(m, "");
+}
+
+namespace vtable = sdbusplus::vtable;
+
+/** @brief Flags for writable properties. */
+static constexpr int rw = SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE;
+/** @brief Flags for read-only properties. */
+static constexpr int ro = SD_BUS_VTABLE_PROPERTY_CONST;
+
+// clang-format off
+static const vtable::vtable_t syscfgVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::syscfgHostname, "s", getProperty, setProperty, rw),
+    vtable::property(Dbus::syscfgDefGw4, "s", getProperty, setProperty, rw),
+    vtable::property(Dbus::syscfgDefGw6, "s", getProperty, setProperty, rw),
+    vtable::end(),
+};
+
+static const vtable::vtable_t dhcpVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::dhcpDnsEnabled, "b", getProperty, setProperty, rw),
+    vtable::property(Dbus::dhcpNtpEnabled, "b", getProperty, setProperty, rw),
+    vtable::end(),
+};
+
+static const vtable::vtable_t ethVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::ethName, "s", getProperty, ro),
+    vtable::property(Dbus::ethDhcpEnabled, "s", getProperty, setProperty, rw),
+    vtable::property(Dbus::ethNtpServers, "as", getProperty, setProperty, rw),
+    vtable::property(Dbus::ethNameServers, "as", getProperty, ro),
+    vtable::property(Dbus::ethStNameServers, "as", getProperty, setProperty, rw),
+    vtable::property(Dbus::ethLinkUp, "b", getProperty, ro),
+    vtable::property(Dbus::ethSpeed, "u", getProperty, ro),
+    vtable::end(),
+};
+
+static const vtable::vtable_t macVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::macSet, "s", getProperty, setProperty, rw),
+    vtable::end(),
+};
+
+static const vtable::vtable_t vlanVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::vlanId, "u", getProperty, ro),
+    vtable::end(),
+};
+
+static const vtable::vtable_t ipVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::ipAddress, "s", getProperty, ro),
+    vtable::property(Dbus::ipPrefix, "y", getProperty, ro),
+    vtable::property(Dbus::ipGateway, "s", getProperty, ro),
+    vtable::property(Dbus::ipOrigin, "s", getProperty, ro),
+    vtable::end(),
+};
+
+static const vtable::vtable_t ipCreateVtable[] = {
+    vtable::start(),
+    vtable::method(Dbus::ipCreateMethod, "ssys", "o", createIp),
+    vtable::end(),
+};
+
+static const vtable::vtable_t vlanCreateVtable[] = {
+    vtable::start(),
+    vtable::method(Dbus::vlanCreateMethod, "su", "o", createVlan),
+    vtable::end(),
+};
+
+static const vtable::vtable_t deleteVtable[] = {
+    vtable::start(),
+    vtable::method(Dbus::deleteMethod, "", "", deleteObject),
+    vtable::end(),
+};
+
+static const vtable::vtable_t resetVtable[] = {
+    vtable::start(),
+    vtable::method(Dbus::resetMethod, "", "", reset),
+    vtable::end(),
+};
+
+static const vtable::vtable_t syslogVtable[] = {
+    vtable::start(),
+    vtable::property(Dbus::syslogAddr, "s", getProperty, setProperty, rw),
+    vtable::property(Dbus::syslogPort, "q", getProperty, setProperty, rw),
+    vtable::end(),
+};
+
+/** @brief Vtables of the supported interfaces. */
+static const std::map<std::string, const vtable::vtable_t*> vtables = {
+    {Dbus::syscfgInterface, syscfgVtable},
+    {Dbus::dhcpInterface, dhcpVtable},
+    {Dbus::ethInterface, ethVtable},
+    {Dbus::macInterface, macVtable},
+    {Dbus::vlanInterface, vlanVtable},
+    {Dbus::ipInterface, ipVtable},
+    {Dbus::ipCreateInterface, ipCreateVtable},
+    {Dbus::vlanCreateInterface, vlanCreateVtable},
+    {Dbus::deleteInterface, deleteVtable},
+    {Dbus::resetInterface, resetVtable},
+    {Dbus::syslogInterface, syslogVtable},
+};
+// clang-format on
+
+void Service::add(const std::string& path,
+                  std::map<std::string, Dbus::Properties>&& interfaces,
+                  bool announce)
+{
+    if (exists(path))
+    {
+        throw std::invalid_argument("Object already exists: " + path);
+    }
+
+    auto object = std::make_unique<Object>(
+        Object{*this, path, std::move(interfaces), {}});
+    for (const auto& it : object->interfaces)
+    {
+        object->handles.emplace_back(
+            std::make_unique<sdbusplus::server::interface::interface>(
+                bus, object->path.c_str(), it.first.c_str(),
+                vtables.at(it.first), object.get()));
+    }
+    objects.emplace(path, std::move(object));
+
+    if (announce)
+    {
+        sd_bus_emit_object_added(bus.get(), path.c_str());
+    }
+}
+
+void Service::remove(const std::string& path)
+{
+    const std::string children = path + '/';
+    auto it = objects.begin();
+    while (it != objects.end())
+    {
+        if (it->first == path || it->first.compare(0, children.size(),
+                                                   children) == 0)
+        {
+            sd_bus_emit_object_removed(bus.get(), it->first.c_str());
+            removed.emplace_back(std::move(it->second));
+            it = objects.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void Service::collect()
+{
+    removed.clear();
+}
+
+bool Service::exists(const std::string& path) const
+{
+    return objects.find(path) != objects.end();
+}
+
+std::string Service::addInterface(const std::string& name, uint32_t vlan,
+                                  bool announce)
+{
+    std::string ifname = name;
+    if (vlan)
+    {
+        ifname += '.';
+        ifname += std::to_string(vlan);
+    }
+    const std::string path = Dbus::ethToPath(ifname.c_str());
+    const size_t index = objects.size();
+
+    char mac[18];
+    snprintf(mac, sizeof(mac), "02:00:00:%02x:%02x:%02x",
+             static_cast<unsigned int>((index >> 16) & 0xff),
+             static_cast<unsigned int>((index >> 8) & 0xff),
+             static_cast<unsigned int>(index & 0xff));
+
+    std::map<std::string, Dbus::Properties> interfaces = {
+        {Dbus::ethInterface,
+         {
+             {Dbus::ethName, ifname},
+             {Dbus::ethDhcpEnabled,
+              std::string("xyz.openbmc_project.Network.EthernetInterface."
+                          "DHCPConf.none")},
+             {Dbus::ethNtpServers, std::vector<std::string>()},
+             {Dbus::ethNameServers, std::vector<std::string>()},
+             {Dbus::ethStNameServers, std::vector<std::string>()},
+             {Dbus::ethLinkUp, true},
+             {Dbus::ethSpeed, static_cast<uint32_t>(1000)},
+         }},
+        {Dbus::macInterface, {{Dbus::macSet, std::string(mac)}}},
+        {Dbus::ipCreateInterface, {}},
+    };
+    if (vlan)
+    {
+        interfaces[Dbus::vlanInterface] = {{Dbus::vlanId, vlan}};
+        interfaces[Dbus::deleteInterface] = {};
+    }
+
+    add(path, std::move(interfaces), announce);
+    return path;
+}
+
+std::string Service::addAddress(const std::string& ethObject,
+                                const std::string& protocol,
+                                const std::string& address, uint8_t prefix,
+                                const std::string& gateway, bool announce)
+{
+    const bool v6 = protocol == Dbus::ip6Interface;
+    const std::string path = ethObject + (v6 ? "/ipv6/" : "/ipv4/") +
+                             std::to_string(++ipIndex);
+
+    add(path,
+        {
+            {Dbus::ipInterface,
+             {
+                 {Dbus::ipAddress, address},
+                 {Dbus::ipPrefix, prefix},
+                 {Dbus::ipGateway, gateway},
+                 {Dbus::ipOrigin, std::string(Dbus::ipOriginStatic)},
+             }},
+            {Dbus::deleteInterface, {}},
+        },
+        announce);
+    return path;
+}
+
+/**
+ * @brief Print help.
+ *
+ * @param[in] app application name
+ */
+static void printHelp(const char* app)
+{
+    printf("Mock of the network configuration services for benchmarks.\n");
+    printf("Usage: %s [OPTION...]\n", app);
+    printf("  -i, --interfaces=N  Number of Ethernet interfaces (default 1)\n");
+    printf("  -v, --vlans=M       Number of VLANs (default 0)\n");
+    printf("  -a, --addresses=K   Number of IP addresses per interface "
+           "(default 1)\n");
+    printf("  -n, --name=NAME     Name of the first interface, must exist in "
+           "the system (default %s)\n",
+           Dbus::defaultEth);
+    printf("  -d, --daemon        Fork and print PID when ready\n");
+    printf("  -h, --help          Print this help and exit\n");
+}
+
+/**
+ * @brief Convert string to number.
+ *
+ * @param[in] arg string to convert
+ * @param[in] max max allowed value
+ *
+ * @throw std::invalid_argument if string is not a valid number
+ *
+ * @return numeric value
+ */
+static size_t toNumber(const char* arg, size_t max)
+{
+    char* end;
+    const unsigned long val = strtoul(arg, &end, 10);
+    if (*end || end == arg || val > max)
+    {
+        std::string err = "Invalid number: ";
+        err += arg;
+        throw std::invalid_argument(err);
+    }
+    return val;
+}
+
+/** @brief Application entry point. */
+int main(int argc, char* argv[])
+{
+    const struct option longOpts[] = {
+        {"interfaces", required_argument, nullptr, 'i'},
+        {"vlans", required_argument, nullptr, 'v'},
+        {"addresses", required_argument, nullptr, 'a'},
+        {"name", required_argument, nullptr, 'n'},
+        {"daemon", no_argument, nullptr, 'd'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+    const char* shortOpts = "i:v:a:n:dh";
+
+    size_t interfaces = 1;
+    size_t vlans = 0;
+    size_t addresses = 1;
+    const char* name = Dbus::defaultEth;
+    bool daemon = false;
+
+    try
+    {
+        int opt;
+        while ((opt = getopt_long(argc, argv, shortOpts, longOpts,
+                                  nullptr)) != -1)
+        {
+            switch (opt)
+            {
+                case 'i':
+                    interfaces = toNumber(optarg, 255);
+                    break;
+                case 'v':
+                    vlans = toNumber(optarg, maxVlanId - minVlanId + 1);
+                    break;
+                case 'a':
+                    addresses = toNumber(optarg, 65536);
+                    break;
+                case 'n':
+                    name = optarg;
+                    break;
+                case 'd':
+                    daemon = true;
+                    break;
+                case 'h':
+                    printHelp(argv[0]);
+                    return EXIT_SUCCESS;
+                default:
+                    return EXIT_FAILURE;
+            }
+        }
+        if (interfaces == 0)
+        {
+            throw std::invalid_argument("At least one interface is required");
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        fprintf(stderr, "%s\n", ex.what());
+        return EXIT_FAILURE;
+    }
+
+    // D-Bus connection can't be used after fork, so fork first and let the
+    // parent wait for the child to be ready
+    int ready = -1;
+    if (daemon)
+    {
+        int fds[2];
+        if (pipe(fds) == -1)
+        {
+            perror("pipe");
+            return EXIT_FAILURE;
+        }
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (pid)
+        {
+            close(fds[1]);
+            char c;
+            if (read(fds[0], &c, 1) != 1)
+            {
+                fprintf(stderr, "Mock service failed to start\n");
+                return EXIT_FAILURE;
+            }
+            printf("%d\n", static_cast<int>(pid));
+            return EXIT_SUCCESS;
+        }
+        close(fds[0]);
+        ready = fds[1];
+        // Release parent's stdout, it is usually read until EOF
+        const int null = open("/dev/null", O_WRONLY);
+        if (null != -1)
+        {
+            dup2(null, STDOUT_FILENO);
+            close(null);
+        }
+    }
+
+    try
+    {
+        auto bus = sdbusplus::bus::new_default();
+        Service service(bus);
+
+        service.add(Dbus::objectRoot,
+                    {
+                        {Dbus::vlanCreateInterface, {}},
+                        {Dbus::resetInterface, {}},
+                    },
+                    false);
+        service.add(Dbus::objectConfig,
+                    {{Dbus::syscfgInterface,
+                      {
+                          {Dbus::syscfgHostname, std::string("mock")},
+                          {Dbus::syscfgDefGw4, std::string()},
+                          {Dbus::syscfgDefGw6, std::string()},
+                      }}},
+                    false);
+        service.add(Dbus::objectDhcp,
+                    {{Dbus::dhcpInterface,
+                      {
+                          {Dbus::dhcpDnsEnabled, true},
+                          {Dbus::dhcpNtpEnabled, true},
+                      }}},
+                    false);
+        service.add(Dbus::objectSyslog,
+                    {{Dbus::syslogInterface,
+                      {
+                          {Dbus::syslogAddr, std::string()},
+                          {Dbus::syslogPort, static_cast<uint16_t>(0)},
+                      }}},
+                    false);
+
+        std::vector<std::string> names;
+        for (size_t i = 0; i < interfaces; ++i)
+        {
+            names.emplace_back(i ? "mock" + std::to_string(i) : name);
+            const std::string path =
+                service.addInterface(names.back(), 0, false);
+            for (size_t a = 0; a < addresses; ++a)
+            {
+                const std::string ip = "10." + std::to_string(i) + '.' +
+                                       std::to_string((a >> 8) & 0xff) + '.' +
+                                       std::to_string(a & 0xff);
+                service.addAddress(path, Dbus::ip4Interface, ip, 16, "",
+                                   false);
+            }
+        }
+        for (size_t v = 0; v < vlans; ++v)
+        {
+            service.addInterface(names[v % interfaces],
+                                 static_cast<uint32_t>(minVlanId + v), false);
+        }
+
+        bus.request_name(Dbus::networkService);
+        bus.request_name(Dbus::syslogService);
+
+        if (ready != -1)
+        {
+            const char c = 0;
+            if (write(ready, &c, 1) != 1)
+            {
+                throw std::runtime_error("Unable to notify parent process");
+            }
+            close(ready);
+        }
+
+        while (true)
+        {
+            while (bus.process_discard())
+            {
+            }
+            service.collect();
+            bus.wait();
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        fprintf(stderr, "%s\n", ex.what());
+    }
+
+    return EXIT_FAILURE;
+}
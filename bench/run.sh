@@ -0,0 +1,102 @@
+#!/bin/sh
+# SPDX-License-Identifier: Apache-2.0
+# Copyright (C) 2021 YADRO
+
+# Measure netconfig command execution time against the mock network service
+# running on a private D-Bus daemon.
+#
+# Usage: run.sh MOCK NETCONFIG INTERFACES VLANS ADDRESSES {show|ip|dns|vlan}
+#
+# Environment:
+#   BENCH_IFACE       network interface used in commands, must exist in the
+#                     system as netconfig checks interface names (default: lo)
+#   BENCH_ITERATIONS  number of iterations (default: 20, max: 250)
+
+set -eu
+
+if [ $# -ne 6 ]; then
+  echo "Usage: $0 MOCK NETCONFIG INTERFACES VLANS ADDRESSES {show|ip|dns|vlan}" >&2
+  exit 1
+fi
+
+mock="$1"
+netconfig="$2"
+interfaces="$3"
+vlans="$4"
+addresses="$5"
+bench="$6"
+iface="${BENCH_IFACE:-lo}"
+iterations="${BENCH_ITERATIONS:-20}"
+opts=""
+
+if [ "${iterations}" -lt 1 ] || [ "${iterations}" -gt 250 ]; then
+  echo "Invalid number of iterations: ${iterations}" >&2
+  exit 1
+fi
+
+tmpdir="$(mktemp -d)"
+bus_pid=""
+mock_pid=""
+cleanup() {
+  [ -z "${mock_pid}" ] || kill "${mock_pid}" 2>/dev/null || true
+  [ -z "${bus_pid}" ] || kill "${bus_pid}" 2>/dev/null || true
+  rm -rf "${tmpdir}"
+}
+trap cleanup EXIT
+
+# netconfig checks its own name, so it must be executed as `netconfig`
+mkdir "${tmpdir}/bin"
+ln -s "$(realpath "${netconfig}")" "${tmpdir}/bin/netconfig"
+PATH="${tmpdir}/bin:${PATH}"
+
+# Private bus, used as both system and session bus
+address="unix:path=${tmpdir}/bus"
+bus_pid="$(dbus-daemon --session --fork --address="${address}" --print-pid)"
+DBUS_SYSTEM_BUS_ADDRESS="${address}"
+DBUS_SESSION_BUS_ADDRESS="${address}"
+export PATH DBUS_SYSTEM_BUS_ADDRESS DBUS_SESSION_BUS_ADDRESS
+
+mock_pid="$("${mock}" --daemon --name="${iface}" --interfaces="${interfaces}" \
+                      --vlans="${vlans}" --addresses="${addresses}")"
+
+# Execute single iteration of the benchmark
+# $1: iteration number
+iteration() {
+  case "${bench}" in
+    show)
+      netconfig ${opts} ifconfig show
+      ;;
+    ip)
+      netconfig ${opts} ifconfig ip "${iface}" add "192.0.2.$1/24"
+      netconfig ${opts} ifconfig ip "${iface}" del "192.0.2.$1"
+      ;;
+    dns)
+      netconfig ${opts} ifconfig dns "${iface}" add "198.51.100.$1"
+      ;;
+    vlan)
+      netconfig ${opts} ifconfig vlan add "${iface}" "$((1000 + $1))"
+      ;;
+    *)
+      echo "Invalid benchmark: ${bench}" >&2
+      exit 1
+      ;;
+  esac
+}
+
+start="$(date +%s%N)"
+i=1
+while [ "${i}" -le "${iterations}" ]; do
+  iteration "${i}" > /dev/null
+  i=$((i + 1))
+done
+end="$(date +%s%N)"
+
+total=$(((end - start) / 1000))
+echo "${bench}: ${interfaces} interfaces, ${vlans} VLANs," \
+     "${addresses} addresses per interface"
+echo "${iterations} iterations, total ${total} us," \
+     "average $((total / iterations)) us"
+
+# Time breakdown of one more iteration
+opts="--stats"
+iteration "$((iterations + 1))" > /dev/null
@@ -0,0 +1,623 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "apply.hpp"
+
+#include "netconfig.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+/** @brief DHCP client modes. */
+static constexpr const char* dhcpBoth =
+    "xyz.openbmc_project.Network.EthernetInterface.DHCPConf.both";
+static constexpr const char* dhcpNone =
+    "xyz.openbmc_project.Network.EthernetInterface.DHCPConf.none";
+
+/**
+ * @brief Remove leading and trailing white spaces.
+ *
+ * @param[in] str source string
+ *
+ * @return trimmed string
+ */
+static std::string trim(const std::string& str)
+{
+    static const char* spaces = " \t\r\n";
+    const size_t begin = str.find_first_not_of(spaces);
+    if (begin == std::string::npos)
+    {
+        return std::string();
+    }
+    const size_t end = str.find_last_not_of(spaces);
+    return str.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief Split string into words.
+ *
+ * @param[in] str source string
+ *
+ * @return array of words
+ */
+static std::vector<std::string> split(const std::string& str)
+{
+    static const char* spaces = " \t\r\n";
+    std::vector<std::string> words;
+    size_t pos = str.find_first_not_of(spaces);
+    while (pos != std::string::npos)
+    {
+        const size_t end = str.find_first_of(spaces, pos);
+        words.emplace_back(str.substr(pos, end - pos));
+        pos = str.find_first_not_of(spaces, end);
+    }
+    return words;
+}
+
+/**
+ * @brief Get properties of the object's interface.
+ *
+ * @param[in] objects network objects
+ * @param[in] path path to the object
+ * @param[in] iface interface name
+ *
+ * @return pointer to properties or nullptr if not found
+ */
+static const Dbus::Properties* findProperties(
+    const Dbus::ManagedObject& objects, const std::string& path,
+    const char* iface)
+{
+    const auto obj = objects.find(path);
+    if (obj != objects.end())
+    {
+        const auto props = obj->second.find(iface);
+        if (props != obj->second.end())
+        {
+            return &props->second;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get property value.
+ *
+ * @param[in] props set of properties, may be nullptr
+ * @param[in] name property name
+ *
+ * @return property value or nothing if not found
+ */
+template <typename T>
+static std::optional<T> findValue(const Dbus::Properties* props,
+                                  const char* name)
+{
+    if (props)
+    {
+        const auto it = props->find(name);
+        if (it != props->end() && std::holds_alternative<T>(it->second))
+        {
+            return std::get<T>(it->second);
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief Join array of strings.
+ *
+ * @param[in] values array to join
+ *
+ * @return string with comma-separated values
+ */
+static std::string join(const std::vector<std::string>& values)
+{
+    std::string str;
+    for (const auto& val : values)
+    {
+        if (!str.empty())
+        {
+            str += ", ";
+        }
+        str += val;
+    }
+    return str.empty() ? "(none)" : str;
+}
+
+Apply::Apply(const char* file)
+{
+    FILE* input = fopen(file, "r");
+    if (!input)
+    {
+        std::string err = "Unable to open file ";
+        err += file;
+        err += ": ";
+        err += strerror(errno);
+        throw std::runtime_error(err);
+    }
+
+    std::string section;
+    size_t lineNum = 0;
+    char* buffer = nullptr;
+    size_t bufferSize = 0;
+
+    try
+    {
+        while (getline(&buffer, &bufferSize, input) != -1)
+        {
+            ++lineNum;
+
+            std::string line = buffer;
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.erase(comment);
+            }
+            line = trim(line);
+            if (line.empty())
+            {
+                continue;
+            }
+
+            if (line.front() == '[')
+            {
+                if (line.back() != ']')
+                {
+                    throw std::invalid_argument("Invalid section header");
+                }
+                section = trim(line.substr(1, line.length() - 2));
+                const auto words = split(section);
+                const bool isIface = words.size() == 2 &&
+                                     words[0] == "interface";
+                if (!isIface && section != "global" && section != "syslog")
+                {
+                    throw std::invalid_argument("Invalid section: " +
+                                                section);
+                }
+                if (isIface)
+                {
+                    section = words[1];
+                    interfaces[section];
+                }
+                continue;
+            }
+
+            const size_t delim = line.find('=');
+            if (delim == std::string::npos || section.empty())
+            {
+                throw std::invalid_argument("Expected 'KEY = VALUE' in a "
+                                            "section");
+            }
+
+            std::vector<std::string> words = split(line.substr(delim + 1));
+            std::vector<char*> argv;
+            for (auto& word : words)
+            {
+                argv.push_back(word.data());
+            }
+            Arguments args(static_cast<int>(argv.size()), argv.data());
+            parse(section, trim(line.substr(0, delim)), args);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        free(buffer);
+        fclose(input);
+
+        std::string err = file;
+        err += ':';
+        err += std::to_string(lineNum);
+        err += ": ";
+        err += ex.what();
+        throw std::invalid_argument(err);
+    }
+
+    free(buffer);
+    fclose(input);
+}
+
+void Apply::parse(const std::string& section, const std::string& key,
+                  Arguments& args)
+{
+    if (section == "global")
+    {
+        if (key == "hostname")
+        {
+            hostname = args.asIpOrFQDN();
+        }
+        else if (key == "gateway" || key == "gateway6")
+        {
+            const IpAddr ip = args.asIpAddress();
+            const IpVer ver = ip.version();
+            if ((ver == IpVer::v4) != (key == "gateway"))
+            {
+                throw std::invalid_argument("Invalid IP version of " + key);
+            }
+            (ver == IpVer::v4 ? gateway4 : gateway6) = ip.str();
+        }
+        else if (key == "dhcp-dns")
+        {
+            dhcpDns = args.asToggle() == Toggle::enable;
+        }
+        else if (key == "dhcp-ntp")
+        {
+            dhcpNtp = args.asToggle() == Toggle::enable;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown parameter: " + key);
+        }
+    }
+    else if (section == "syslog")
+    {
+        if (key != "server")
+        {
+            throw std::invalid_argument("Unknown parameter: " + key);
+        }
+        const char* arg = args.peek();
+        if (arg && !strcmp(arg, "none"))
+        {
+            syslog = std::make_tuple(std::string(), 0);
+        }
+        else
+        {
+            syslog = args.parseAddrAndPort();
+        }
+        args.asText();
+    }
+    else
+    {
+        Interface& iface = interfaces[section];
+        if (key == "dhcp")
+        {
+            iface.dhcp = args.asToggle();
+        }
+        else if (key == "ip")
+        {
+            iface.ip.emplace();
+            while (args.peek())
+            {
+                iface.ip->emplace_back(args.asIpAddrMask());
+            }
+        }
+        else if (key == "dns")
+        {
+            iface.dns.emplace();
+            while (args.peek())
+            {
+                iface.dns->emplace_back(args.asIpAddress().str());
+            }
+        }
+        else if (key == "ntp")
+        {
+            iface.ntp.emplace();
+            while (args.peek())
+            {
+                iface.ntp->emplace_back(args.asIpOrFQDN());
+            }
+        }
+        else if (key == "vlan")
+        {
+            iface.vlan.emplace();
+            while (args.peek())
+            {
+                const size_t id = args.asNumber();
+                if (id < minVlanId || id > maxVlanId)
+                {
+                    throw std::invalid_argument(
+                        "Invalid VLAN ID. Must be [2 - 4094], see IEEE "
+                        "802.1Q.");
+                }
+                iface.vlan->push_back(static_cast<uint32_t>(id));
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown parameter: " + key);
+        }
+    }
+    args.expectEnd();
+}
+
+size_t Apply::run(Dbus& bus, bool dryRun)
+{
+    std::vector<Operation> ops;
+
+    // Current states of the network and syslog services are requested
+    // simultaneously
+    const bool network = hostname || gateway4 || gateway6 || dhcpDns ||
+                         dhcpNtp || !interfaces.empty();
+    const Dbus::Interfaces filter = {Dbus::syscfgInterface,
+                                     Dbus::dhcpInterface, Dbus::ethInterface,
+                                     Dbus::vlanInterface, Dbus::ipInterface};
+    Dbus::ManagedObject objects;
+    std::tuple<std::string, uint16_t> curSyslog;
+    Dbus::AsyncScope scope(bus);
+    if (network)
+    {
+        bus.getManagedObjectsAsync(filter, objects);
+    }
+    if (syslog)
+    {
+        bus.getSyslogAsync(curSyslog);
+    }
+    bus.waitAll();
+
+    if (network)
+    {
+        planNetwork(objects, ops);
+    }
+    if (syslog)
+    {
+        planSyslog(curSyslog, ops);
+    }
+
+    if (ops.empty())
+    {
+        puts("Configuration is up to date, nothing to do");
+        return 0;
+    }
+
+    for (const auto& op : ops)
+    {
+        printf("%s%s...\n", dryRun ? "(dry run) " : "",
+               op.description.c_str());
+        if (!dryRun)
+        {
+            op.fn(bus);
+        }
+    }
+    if (!dryRun)
+    {
+        printf("%zu requests have been sent\n", ops.size());
+    }
+
+    return ops.size();
+}
+
+void Apply::planNetwork(const Dbus::ManagedObject& objects,
+                        std::vector<Operation>& ops) const
+{
+    const Dbus::Properties* syscfg =
+        findProperties(objects, Dbus::objectConfig, Dbus::syscfgInterface);
+    const Dbus::Properties* dhcpcfg =
+        findProperties(objects, Dbus::objectDhcp, Dbus::dhcpInterface);
+
+    if (hostname &&
+        findValue<std::string>(syscfg, Dbus::syscfgHostname) != hostname)
+    {
+        ops.push_back({"Set host name " + *hostname,
+                       [name = *hostname](Dbus& bus) {
+                           bus.set(Dbus::networkService, Dbus::objectConfig,
+                                   Dbus::syscfgInterface, Dbus::syscfgHostname,
+                                   name);
+                       }});
+    }
+
+    const std::pair<const char*, std::optional<bool>> dhcpFeatures[] = {
+        {Dbus::dhcpDnsEnabled, dhcpDns},
+        {Dbus::dhcpNtpEnabled, dhcpNtp},
+    };
+    for (const auto& [property, enable] : dhcpFeatures)
+    {
+        if (enable && findValue<bool>(dhcpcfg, property) != enable)
+        {
+            std::string descr = *enable ? "Enable " : "Disable ";
+            descr += property == Dbus::dhcpDnsEnabled ? "DNS" : "NTP";
+            descr += " over DHCP";
+            ops.push_back({descr, [property = property,
+                                   enable = *enable](Dbus& bus) {
+                               bus.set(Dbus::networkService, Dbus::objectDhcp,
+                                       Dbus::dhcpInterface, property, enable);
+                           }});
+        }
+    }
+
+    // Existing VLANs of each parent interface
+    std::map<std::string, std::map<uint32_t, std::string>> vlans;
+    for (const auto& [name, iface] : interfaces)
+    {
+        if (!iface.vlan)
+        {
+            continue;
+        }
+        const std::string prefix = Dbus::ethToPath(name.c_str()) + '_';
+        auto& existing = vlans[name];
+        for (const auto& [path, ifaces] : objects)
+        {
+            const std::string& strPath = path;
+            const auto vlan = ifaces.find(Dbus::vlanInterface);
+            if (vlan != ifaces.end() &&
+                strPath.compare(0, prefix.length(), prefix) == 0)
+            {
+                const auto id =
+                    findValue<uint32_t>(&vlan->second, Dbus::vlanId);
+                if (id)
+                {
+                    existing.emplace(*id, strPath);
+                }
+            }
+        }
+
+        // VLANs must be created before configuring them
+        for (const uint32_t id : *iface.vlan)
+        {
+            if (existing.find(id) == existing.end())
+            {
+                ops.push_back(
+                    {"Add VLAN " + std::to_string(id) + " on " + name,
+                     [name = name, id](Dbus& bus) {
+                         bus.call(Dbus::networkService, Dbus::objectRoot,
+                                  Dbus::vlanCreateInterface,
+                                  Dbus::vlanCreateMethod, name, id);
+                     }});
+            }
+        }
+    }
+
+    for (const auto& [name, iface] : interfaces)
+    {
+        planInterface(name, iface, objects, ops);
+    }
+
+    // Gateways must be reachable via already configured addresses
+    const std::pair<const char*, std::optional<std::string>> gateways[] = {
+        {Dbus::syscfgDefGw4, gateway4},
+        {Dbus::syscfgDefGw6, gateway6},
+    };
+    for (const auto& [property, gateway] : gateways)
+    {
+        if (gateway && findValue<std::string>(syscfg, property) != gateway)
+        {
+            ops.push_back({"Set default gateway " + *gateway,
+                           [property = property, ip = *gateway](Dbus& bus) {
+                               bus.set(Dbus::networkService,
+                                       Dbus::objectConfig,
+                                       Dbus::syscfgInterface, property, ip);
+                           }});
+        }
+    }
+
+    for (const auto& [name, existing] : vlans)
+    {
+        const auto& desired = *interfaces.at(name).vlan;
+        for (const auto& [id, path] : existing)
+        {
+            if (std::find(desired.begin(), desired.end(), id) == desired.end())
+            {
+                ops.push_back({"Remove VLAN " + std::to_string(id) + " on " +
+                                   name,
+                               [path = path](Dbus& bus) {
+                                   bus.call(Dbus::networkService, path.c_str(),
+                                            Dbus::deleteInterface,
+                                            Dbus::deleteMethod);
+                               }});
+            }
+        }
+    }
+}
+
+void Apply::planInterface(const std::string& name, const Interface& iface,
+                          const Dbus::ManagedObject& objects,
+                          std::vector<Operation>& ops) const
+{
+    const std::string object = Dbus::ethToPath(name.c_str());
+    const Dbus::Properties* eth =
+        findProperties(objects, object, Dbus::ethInterface);
+
+    if (iface.dhcp)
+    {
+        const std::string mode =
+            *iface.dhcp == Toggle::enable ? dhcpBoth : dhcpNone;
+        if (findValue<std::string>(eth, Dbus::ethDhcpEnabled) != mode)
+        {
+            ops.push_back({std::string(*iface.dhcp == Toggle::enable
+                                           ? "Enable"
+                                           : "Disable") +
+                               " DHCP client on " + name,
+                           [object, mode](Dbus& bus) {
+                               bus.set(Dbus::networkService, object.c_str(),
+                                       Dbus::ethInterface,
+                                       Dbus::ethDhcpEnabled, mode);
+                           }});
+        }
+    }
+
+    if (iface.ip)
+    {
+        // Only static addresses are managed
+        std::vector<Dbus::IpAddress> current;
+        for (const auto& addr : Dbus::getAddresses(object.c_str(), objects))
+        {
+            if (addr.origin.empty() || addr.origin == Dbus::ipOriginStatic)
+            {
+                current.push_back(addr);
+            }
+        }
+
+        for (const auto& [ip, mask] : *iface.ip)
+        {
+            const auto it = std::find_if(
+                current.begin(), current.end(),
+                [&ip = ip](const auto& addr) { return addr.address == ip; });
+            if (it != current.end())
+            {
+                if (it->mask == mask)
+                {
+                    current.erase(it);
+                    continue;
+                }
+                // Prefix length can be changed only by re-creating address
+                ops.push_back({"Remove IP " + it->address.str() + '/' +
+                                   std::to_string(it->mask) + " from " + name,
+                               [path = it->object](Dbus& bus) {
+                                   bus.call(Dbus::networkService, path.c_str(),
+                                            Dbus::deleteInterface,
+                                            Dbus::deleteMethod);
+                               }});
+                current.erase(it);
+            }
+            const char* proto = ip.version() == IpVer::v4 ? Dbus::ip4Interface
+                                                          : Dbus::ip6Interface;
+            ops.push_back({"Add IP " + ip.str() + '/' + std::to_string(mask) +
+                               " to " + name,
+                           [object, proto, ip = ip.str(),
+                            mask = mask](Dbus& bus) {
+                               bus.call(Dbus::networkService, object.c_str(),
+                                        Dbus::ipCreateInterface,
+                                        Dbus::ipCreateMethod, proto, ip, mask,
+                                        "");
+                           }});
+        }
+
+        // Obsolete addresses are removed after adding the new ones to keep
+        // the management interface reachable
+        for (const auto& addr : current)
+        {
+            ops.push_back({"Remove IP " + addr.address.str() + '/' +
+                               std::to_string(addr.mask) + " from " + name,
+                           [path = addr.object](Dbus& bus) {
+                               bus.call(Dbus::networkService, path.c_str(),
+                                        Dbus::deleteInterface,
+                                        Dbus::deleteMethod);
+                           }});
+        }
+    }
+
+    const std::tuple<const char*, const char*,
+                     const std::optional<std::vector<std::string>>&>
+        lists[] = {
+            {"DNS", Dbus::ethStNameServers, iface.dns},
+            {"NTP", Dbus::ethNtpServers, iface.ntp},
+        };
+    for (const auto& [title, property, servers] : lists)
+    {
+        if (servers &&
+            findValue<std::vector<std::string>>(eth, property) != servers)
+        {
+            ops.push_back({std::string("Set ") + title + " servers on " +
+                               name + ": " + join(*servers),
+                           [object, property = property,
+                            servers = *servers](Dbus& bus) {
+                               bus.set(Dbus::networkService, object.c_str(),
+                                       Dbus::ethInterface, property, servers);
+                           }});
+        }
+    }
+}
+
+void Apply::planSyslog(const std::tuple<std::string, uint16_t>& current,
+                       std::vector<Operation>& ops) const
+{
+    const auto& [addr, port] = *syslog;
+    const auto& [curAddr, curPort] = current;
+
+    if (curAddr != addr || curPort != port)
+    {
+        std::string descr = "Set remote syslog server ";
+        descr += addr.empty() ? "(none)" : addr + ':' + std::to_string(port);
+        ops.push_back({descr, [addr = addr, port = port](Dbus& bus) {
+                           bus.setSyslog(addr, port);
+                       }});
+    }
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "arguments.hpp"
+#include "dbus.hpp"
+
+#include <functional>
+#include <map>
+#include <optional>
+
+/**
+ * @class Apply
+ * @brief Brings network configuration to the state described in a file.
+ *
+ * Only settings specified in the file are managed. Current state is read
+ * once and only the write calls needed to reach the desired state are sent,
+ * so applying the same file twice doesn't touch the network service.
+ *
+ * File format:
+ * @code
+ * [global]
+ * hostname = bmc
+ * gateway = 10.0.0.1
+ * gateway6 = 2001:db8::1
+ * dhcp-dns = enable
+ * dhcp-ntp = disable
+ *
+ * [interface eth0]
+ * dhcp = disable
+ * ip = 10.0.0.2/24 2001:db8::2/64
+ * dns = 10.0.0.3
+ * ntp = pool.ntp.org
+ * vlan = 100
+ *
+ * [interface eth0.100]
+ * ip = 192.168.0.2/24
+ *
+ * [syslog]
+ * server = 10.0.0.4:514
+ * @endcode
+ */
+class Apply
+{
+  public:
+    /**
+     * @brief Constructor: loads the desired state description.
+     *
+     * @param[in] file path to the file
+     *
+     * @throw std::exception if file can not be read or has invalid format
+     */
+    Apply(const char* file);
+
+    /**
+     * @brief Apply the desired state.
+     *
+     * @param[in] bus D-Bus instance
+     * @param[in] dryRun print planned changes without applying them
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return number of write calls (planned ones in dry run mode)
+     */
+    size_t run(Dbus& bus, bool dryRun);
+
+  private:
+    /** @brief IP address with prefix length. */
+    using IpAddrMask = std::tuple<IpAddr, uint8_t>;
+
+    /**
+     * @struct Interface
+     * @brief Desired state of the network interface.
+     */
+    struct Interface
+    {
+        /** @brief DHCP client state. */
+        std::optional<Toggle> dhcp;
+        /** @brief Static IP addresses. */
+        std::optional<std::vector<IpAddrMask>> ip;
+        /** @brief Static DNS servers. */
+        std::optional<std::vector<std::string>> dns;
+        /** @brief NTP servers. */
+        std::optional<std::vector<std::string>> ntp;
+        /** @brief VLAN IDs. */
+        std::optional<std::vector<uint32_t>> vlan;
+    };
+
+    /**
+     * @struct Operation
+     * @brief Single write call.
+     */
+    struct Operation
+    {
+        /** @brief Human readable description. */
+        std::string description;
+        /** @brief Function that performs the call. */
+        std::function<void(Dbus&)> fn;
+    };
+
+    /**
+     * @brief Handle single "key = value" line of the file.
+     *
+     * @param[in] section current section name
+     * @param[in] key parameter name
+     * @param[in] args parameter values
+     *
+     * @throw std::invalid_argument if parameter is invalid
+     */
+    void parse(const std::string& section, const std::string& key,
+               Arguments& args);
+
+    /**
+     * @brief Compare desired and current network state and make the list
+     *        of write operations.
+     *
+     * @param[in] objects current network objects
+     * @param[out] ops list of operations
+     */
+    void planNetwork(const Dbus::ManagedObject& objects,
+                     std::vector<Operation>& ops) const;
+
+    /**
+     * @brief Compare desired and current interface state and make the list
+     *        of write operations.
+     *
+     * @param[in] name interface name
+     * @param[in] iface desired interface state
+     * @param[in] objects current network objects
+     * @param[out] ops list of operations
+     */
+    void planInterface(const std::string& name, const Interface& iface,
+                       const Dbus::ManagedObject& objects,
+                       std::vector<Operation>& ops) const;
+
+    /**
+     * @brief Compare desired and current syslog state and make the list
+     *        of write operations.
+     *
+     * @param[in] current current server address and port
+     * @param[out] ops list of operations
+     */
+    void planSyslog(const std::tuple<std::string, uint16_t>& current,
+                    std::vector<Operation>& ops) const;
+
+  private:
+    /** @brief Host name. */
+    std::optional<std::string> hostname;
+    /** @brief Default IPv4 gateway. */
+    std::optional<std::string> gateway4;
+    /** @brief Default IPv6 gateway. */
+    std::optional<std::string> gateway6;
+    /** @brief DNS over DHCP. */
+    std::optional<bool> dhcpDns;
+    /** @brief NTP over DHCP. */
+    std::optional<bool> dhcpNtp;
+    /** @brief Network interfaces. */
+    std::map<std::string, Interface> interfaces;
+    /** @brief Remote syslog server address and port. */
+    std::optional<std::tuple<std::string, unsigned short>> syslog;
+};
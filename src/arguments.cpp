@@ -3,15 +3,15 @@
 
 #include "arguments.hpp"
 
-#include <arpa/inet.h>
-#include <ifaddrs.h>
+#include "netifaces.hpp"
+
 #include <netinet/ether.h>
 #include <sys/types.h>
 
 #include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <numeric>
-#include <regex>
 #include <stdexcept>
 
 /** @brief Max length of a numeric value. */
@@ -55,6 +55,33 @@ const char* Arguments::peekNext() const
     return nullptr;
 }
 
+std::optional<std::string> Arguments::takeOption(const char* name)
+{
+    const size_t nameLen = strlen(name);
+    const auto it = std::find_if(current, args.cend(), [&](const char* arg) {
+        return strncmp(arg, name, nameLen) == 0 &&
+               (arg[nameLen] == '\0' || arg[nameLen] == '=');
+    });
+    if (it == args.cend())
+    {
+        return std::nullopt;
+    }
+
+    const char* value = *it + nameLen;
+    std::string option = *value ? value + 1 : value;
+
+    const auto pos = current - args.cbegin();
+    args.erase(it);
+    current = args.cbegin() + pos;
+
+    return option;
+}
+
+std::vector<const char*> Arguments::tail() const
+{
+    return std::vector<const char*>(current, args.cend());
+}
+
 const char* Arguments::asText()
 {
     const char* arg = peek();
@@ -101,6 +128,60 @@ size_t Arguments::asNumber()
     return strtoul(arg, nullptr, 0);
 }
 
+std::vector<std::pair<uint32_t, uint32_t>> Arguments::asRanges()
+{
+    const char* arg = asText();
+    const char* end = arg + strlen(arg);
+
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    const char* ptr = arg;
+    while (true)
+    {
+        uint32_t first, last;
+        auto res = std::from_chars(ptr, end, first);
+        bool valid = res.ec == std::errc() && res.ptr != ptr;
+        last = first;
+        if (valid && *res.ptr == '-')
+        {
+            ptr = res.ptr + 1;
+            res = std::from_chars(ptr, end, last);
+            valid = res.ec == std::errc() && res.ptr != ptr && first <= last;
+        }
+        if (!valid || (*res.ptr != ',' && *res.ptr != 0))
+        {
+            std::string err = "Invalid range argument: ";
+            err += arg;
+            throw std::invalid_argument(err);
+        }
+        ranges.emplace_back(first, last);
+        if (!*res.ptr)
+        {
+            break;
+        }
+        ptr = res.ptr + 1;
+    }
+
+    // Sort and merge overlapping or adjacent ranges
+    std::sort(ranges.begin(), ranges.end());
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        auto& prev = ranges[merged];
+        if (ranges[i].first <= prev.second ||
+            ranges[i].first - prev.second == 1)
+        {
+            prev.second = std::max(prev.second, ranges[i].second);
+        }
+        else
+        {
+            ranges[++merged] = ranges[i];
+        }
+    }
+    ranges.resize(merged + 1);
+
+    return ranges;
+}
+
 Action Arguments::asAction()
 {
     const char* add = "add";
@@ -121,17 +202,7 @@ const char* Arguments::asNetInterface()
 {
     const char* arg = asText();
 
-    bool found = false;
-    ifaddrs* ifaddr;
-    if (getifaddrs(&ifaddr) == 0)
-    {
-        for (ifaddrs* ifa = ifaddr; ifa && !found; ifa = ifa->ifa_next)
-        {
-            found = strcmp(arg, ifa->ifa_name) == 0;
-        }
-        freeifaddrs(ifaddr);
-    }
-    if (!found)
+    if (!NetIfaces::instance().index(arg))
     {
         std::string err = "Invalid network interface name: ";
         err += arg;
@@ -154,7 +225,7 @@ const char* Arguments::asMacAddress()
     return arg;
 }
 
-std::tuple<IpVer, std::string> Arguments::asIpAddress()
+IpAddr Arguments::asIpAddress()
 {
     const char* arg = asText();
 
@@ -171,7 +242,7 @@ std::tuple<IpVer, std::string> Arguments::asIpAddress()
     }
 }
 
-std::tuple<IpVer, std::string, uint8_t> Arguments::asIpAddrMask()
+std::tuple<IpAddr, uint8_t> Arguments::asIpAddrMask()
 {
     const char* arg = asText();
     const char* delim = strrchr(arg, '/');
@@ -183,7 +254,8 @@ std::tuple<IpVer, std::string, uint8_t> Arguments::asIpAddrMask()
             const std::string addr(arg, delim);
             try
             {
-                const auto [ver, ip] = parseIpAddress(addr.c_str());
+                const IpAddr ip = parseIpAddress(addr.c_str());
+                const IpVer ver = ip.version();
 
                 constexpr size_t ip4MaxPrefix = 32;
                 constexpr size_t ip6MaxPrefix = 64;
@@ -191,7 +263,7 @@ std::tuple<IpVer, std::string, uint8_t> Arguments::asIpAddrMask()
                 if (prefix && ((ver == IpVer::v4 && prefix <= ip4MaxPrefix) ||
                                (ver == IpVer::v6 && prefix <= ip6MaxPrefix)))
                 {
-                    return std::make_tuple(ver, ip, prefix);
+                    return std::make_tuple(ip, prefix);
                 }
             }
             catch (const std::invalid_argument&)
@@ -204,12 +276,12 @@ std::tuple<IpVer, std::string, uint8_t> Arguments::asIpAddrMask()
     {
         try
         {
-            const auto [ver, ip] = parseIpAddress(arg);
+            const IpAddr ip = parseIpAddress(arg);
             constexpr uint8_t ip4Prefix = 24;
             constexpr uint8_t ip6Prefix = 64;
 
-            return std::make_tuple(ver, ip,
-                                   ver == IpVer::v4 ? ip4Prefix : ip6Prefix);
+            return std::make_tuple(
+                ip, ip.version() == IpVer::v4 ? ip4Prefix : ip6Prefix);
         }
         catch (const std::invalid_argument&)
         {
@@ -236,35 +308,14 @@ std::string Arguments::asIpOrFQDN(const std::optional<std::string>& param)
 
     try
     {
-        auto [_, addr] = parseIpAddress(arg);
-        return addr;
+        return parseIpAddress(arg).str();
     }
     catch (const std::invalid_argument&)
     {
         // pass
     }
 
-    static const std::regex r(
-        // According to RFC2181:
-        // A full domain name is limited to 255 octets
-        // (including separators),
-        "(?=^.{1,255}$)"
-        "(^"
-        // - The length of any single label is limited to 63 octets.
-        // - labels must not start or end with hyphens.
-        // According to RFC1123 (section 2.1):
-        // "...a segment of a host domain name is now allowed
-        // to begin with a digit and could legally be entirely numeric".
-        // - Total number of labels is limited to 127
-        "((?!-)[a-z0-9-]{0,62}[a-z0-9]\\.){0,126}"
-        // Trailing dot is optional.
-        // According to RFC1738 (section 3.1):
-        // "The rightmost domain label will never start with a digit".
-        "((?![0-9-])[a-z0-9-]{0,62}[a-z0-9]\\.?)"
-        "$)",
-        std::regex_constants::icase);
-
-    if (std::regex_match(arg, r))
+    if (isFQDN(arg))
     {
         return arg;
     }
@@ -286,32 +337,14 @@ bool Arguments::isNumber(const char* arg)
     return std::all_of(arg, arg + len, isdigit);
 }
 
-std::tuple<IpVer, std::string> Arguments::parseIpAddress(const char* arg)
+IpAddr Arguments::parseIpAddress(const char* arg)
 {
     if (arg)
     {
-        constexpr auto bufferMaxSize = sizeof(struct in6_addr);
-        char dummy[bufferMaxSize];
-        int family = 0;
-
-        if (inet_pton(AF_INET, arg, dummy) == 1)
-        {
-            family = AF_INET;
-        }
-        else if (inet_pton(AF_INET6, arg, dummy) == 1)
+        const auto ip = IpAddr::parse(arg);
+        if (ip)
         {
-            family = AF_INET6;
-        }
-
-        if (family != 0)
-        {
-            std::string ip(INET6_ADDRSTRLEN, '\0');
-            if (inet_ntop(family, dummy, ip.data(), ip.size()) != nullptr)
-            {
-                ip.resize(strlen(ip.c_str()));
-                return std::make_tuple(
-                    (family == AF_INET ? IpVer::v4 : IpVer::v6), ip);
-            }
+            return *ip;
         }
     }
 
@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include "ipaddr.hpp"
+
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -28,16 +31,6 @@ enum class Toggle
     disable
 };
 
-/**
- * @class IpVer
- * @brief IP version.
- */
-enum class IpVer
-{
-    v4 = 4,
-    v6 = 6
-};
-
 /** @brief Default remote syslog server port */
 static constexpr uint16_t syslogDefPort = 514;
 
@@ -84,6 +77,26 @@ class Arguments
      */
     const char* peekNext() const;
 
+    /**
+     * @brief Extract option from the rest of arguments.
+     *        Option is expected in format `NAME` or `NAME=VALUE` and can be
+     *        placed anywhere after the current argument.
+     *
+     * @param[in] name option name, e.g. "--wait"
+     *
+     * @return option value (empty string if option has no value) or nothing
+     *         if option is not specified
+     */
+    std::optional<std::string> takeOption(const char* name);
+
+    /**
+     * @brief Get all arguments starting from the current one.
+     *        Argument pointer is not moved.
+     *
+     * @return array of arguments
+     */
+    std::vector<const char*> tail() const;
+
     /**
      * @brief Get current argument as pointer to text data.
      *        Argument pointer will be moved to the next entry.
@@ -118,6 +131,18 @@ class Arguments
      */
     size_t asNumber();
 
+    /**
+     * @brief Get current argument as list of numeric ranges, e.g.
+     *        "100-199,300,305-310".
+     *        Argument pointer will be moved to the next entry.
+     *
+     * @throw std::invalid_argument if there are no more arguments to handle
+     *                              or argument has invalid format
+     *
+     * @return sorted list of non-overlapping inclusive ranges
+     */
+    std::vector<std::pair<uint32_t, uint32_t>> asRanges();
+
     /**
      * @brief Get current argument as action.
      *        Argument pointer will be moved to the next entry.
@@ -169,9 +194,9 @@ class Arguments
      * @throw std::invalid_argument if there are no more arguments to handle
      *                              or argument is not a valid IP address
      *
-     * @return argument value: IP version and address
+     * @return argument value: IP address
      */
-    std::tuple<IpVer, std::string> asIpAddress();
+    IpAddr asIpAddress();
 
     /**
      * @brief Get current argument as IP address with prefix length.
@@ -180,9 +205,9 @@ class Arguments
      * @throw std::invalid_argument if there are no more arguments to handle
      *                              or argument has invalid format
      *
-     * @return argument value: IP version, address and prefix len as bits count
+     * @return argument value: IP address and prefix len as bits count
      */
-    std::tuple<IpVer, std::string, uint8_t> asIpAddrMask();
+    std::tuple<IpAddr, uint8_t> asIpAddrMask();
 
     /**
      * @brief Get current argument as IP address or hostname.
@@ -246,9 +271,75 @@ class Arguments
      *
      * @throw std::invalid_argument if parsing is failed
      *
-     * @return IP version and string with the IP address in unified format.
+     * @return IP address
+     */
+    static IpAddr parseIpAddress(const char* arg);
+
+    /**
+     * @brief Check for fully qualified domain name format.
+     *        According to RFC 2181 and RFC 1123 (section 2.1):
+     *        - full domain name is limited to 255 octets (including
+     *          separators and the optional trailing dot);
+     *        - the length of any single label is limited to 63 octets;
+     *        - labels consist of letters, digits and hyphens, and must not
+     *          start or end with a hyphen;
+     *        - total number of labels is limited to 127.
+     *        According to RFC 1738 (section 3.1) the rightmost domain label
+     *        never starts with a digit.
+     *
+     * @param[in] name value to check
+     *
+     * @return false if checked value is not a domain name
      */
-    static std::tuple<IpVer, std::string> parseIpAddress(const char* arg);
+    static constexpr bool isFQDN(std::string_view name)
+    {
+        constexpr size_t maxNameLen = 255;
+        constexpr size_t maxLabelLen = 63;
+        constexpr size_t maxLabels = 127;
+
+        if (name.empty() || name.size() > maxNameLen)
+        {
+            return false;
+        }
+        if (name.back() == '.')
+        {
+            name.remove_suffix(1);
+        }
+
+        size_t labels = 0;
+        size_t labelLen = 0;
+        char first = 0; // First character of the current label
+        char prev = 0;
+        // The end of name is handled as a label separator
+        for (size_t i = 0; i <= name.size(); ++i)
+        {
+            const char c = i < name.size() ? name[i] : '.';
+            if (c == '.')
+            {
+                if (!labelLen || prev == '-' || ++labels > maxLabels)
+                {
+                    return false;
+                }
+                labelLen = 0;
+            }
+            else
+            {
+                if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9') || c == '-') ||
+                    (!labelLen && c == '-') || ++labelLen > maxLabelLen)
+                {
+                    return false;
+                }
+                if (labelLen == 1)
+                {
+                    first = c;
+                }
+            }
+            prev = c;
+        }
+
+        return !(first >= '0' && first <= '9');
+    }
 
   private:
     using Args = std::vector<char*>;
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "batch.hpp"
+
+#include "dbus.hpp"
+#include "netconfig.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Get time elapsed since specified point.
+ *
+ * @param[in] start start point
+ *
+ * @return elapsed time in milliseconds
+ */
+static double elapsedMs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+std::vector<std::string> splitCommand(const char* line)
+{
+    static const char* delimiters = " \t\r\n";
+
+    std::vector<std::string> words;
+    while (*line)
+    {
+        line += strspn(line, delimiters);
+        const size_t len = strcspn(line, delimiters);
+        if (len)
+        {
+            words.emplace_back(line, len);
+        }
+        line += len;
+    }
+    return words;
+}
+
+/**
+ * @brief Execute single command.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] words command line split into words
+ *
+ * @throw std::exception in case of errors
+ */
+static void executeLine(Dbus& bus, std::vector<std::string>& words)
+{
+    std::vector<char*> argv;
+    argv.reserve(words.size());
+    for (auto& word : words)
+    {
+        argv.push_back(word.data());
+    }
+
+    Arguments args(static_cast<int>(argv.size()), argv.data());
+    if (!strcmp(args.peek(), netCnfg))
+    {
+        ++args;
+    }
+
+    const char* app;
+    const char* cmd = args.asText();
+    if (!strcmp(cmd, ifcfg))
+    {
+        app = rootIfconfig;
+    }
+    else if (!strcmp(cmd, sslg))
+    {
+        app = rootSyslog;
+    }
+    else
+    {
+        std::string err = "Invalid command: ";
+        err += cmd;
+        err += ", expected one of [ifconfig, syslog]";
+        throw std::invalid_argument(err);
+    }
+
+    execute(bus, app, args);
+}
+
+size_t batch(const char* file)
+{
+    const bool useStdin = !strcmp(file, "-");
+    FILE* input = useStdin ? stdin : fopen(file, "r");
+    if (!input)
+    {
+        std::string err = "Unable to open file ";
+        err += file;
+        err += ": ";
+        err += strerror(errno);
+        throw std::runtime_error(err);
+    }
+
+    const auto batchStart = Clock::now();
+    size_t lineNum = 0;
+    size_t total = 0;
+    size_t failed = 0;
+
+    Dbus bus;
+
+    char* line = nullptr;
+    size_t lineSize = 0;
+    while (getline(&line, &lineSize, input) != -1)
+    {
+        ++lineNum;
+        std::vector<std::string> words = splitCommand(line);
+        if (words.empty() || words.front()[0] == '#')
+        {
+            continue;
+        }
+
+        ++total;
+        const auto start = Clock::now();
+        try
+        {
+            executeLine(bus, words);
+            printf("Line %zu: OK (%.3f ms)\n", lineNum, elapsedMs(start));
+        }
+        catch (const std::exception& ex)
+        {
+            ++failed;
+            printError(ex);
+            printf("Line %zu: FAILED (%.3f ms)\n", lineNum, elapsedMs(start));
+        }
+        fflush(stdout);
+    }
+    free(line);
+
+    if (!useStdin)
+    {
+        fclose(input);
+    }
+
+    printf("Batch completed: %zu commands, %zu failed, %.3f ms total\n",
+           total, failed, elapsedMs(batchStart));
+
+    return failed;
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Split command line into words.
+ *
+ * @param[in] line command line
+ *
+ * @return array of words
+ */
+std::vector<std::string> splitCommand(const char* line);
+
+/**
+ * @brief Execute configuration commands from the file, one command per line.
+ *        All commands share the same D-Bus connection.
+ *        Empty lines and lines started with '#' are ignored.
+ *
+ * @param[in] file path to the file with commands, "-" for stdin
+ *
+ * @throw std::exception if file can not be opened
+ *
+ * @return number of failed commands
+ */
+size_t batch(const char* file);
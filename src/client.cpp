@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "client.hpp"
+
+#include "config.hpp"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/** @brief Max time to wait for the daemon to get to our request, seconds. */
+static constexpr time_t readyTimeout = 1;
+
+bool executeRemote(const char* app, const Arguments& args, int& status)
+{
+    std::string request = app;
+    request += '\0';
+    for (const char* arg : args.tail())
+    {
+        request += arg;
+        request += '\0';
+    }
+    if (request.size() > maxRequestSize)
+    {
+        return false;
+    }
+
+    const int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock == -1)
+    {
+        return false;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, NETCONFIGD_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+    {
+        close(sock);
+        return false;
+    }
+
+    // The daemon serves clients one by one: if it is busy or hung, the
+    // command is executed locally. The request is not sent yet, so it can't
+    // be executed twice.
+    timeval timeout = {readyTimeout, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string packet(1 + maxChunkSize, '\0');
+    if (recv(sock, packet.data(), packet.size(), 0) != 1 ||
+        static_cast<Reply>(packet[0]) != Reply::ready ||
+        send(sock, request.data(), request.size(), MSG_NOSIGNAL) == -1)
+    {
+        close(sock);
+        return false;
+    }
+
+    // Output is printed after the whole reply is received, so the daemon
+    // never waits for our stdout
+    timeout = {0, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string out;
+    std::string err;
+    bool done = false;
+    while (true)
+    {
+        const ssize_t rc = recv(sock, packet.data(), packet.size(), 0);
+        if (rc <= 0)
+        {
+            break;
+        }
+        const Reply type = static_cast<Reply>(packet[0]);
+        const char* data = packet.data() + 1;
+        const size_t size = rc - 1;
+        if (type == Reply::out)
+        {
+            out.append(data, size);
+        }
+        else if (type == Reply::err)
+        {
+            err.append(data, size);
+        }
+        else if (type == Reply::status)
+        {
+            int32_t reply;
+            if (size == sizeof(reply))
+            {
+                memcpy(&reply, data, sizeof(reply));
+                status = reply;
+                done = true;
+            }
+            break;
+        }
+    }
+    close(sock);
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    fwrite(err.data(), 1, err.size(), stderr);
+    if (!done)
+    {
+        throw std::runtime_error("Connection to netconfigd lost");
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "arguments.hpp"
+
+#include <cstdint>
+
+/** @brief Max size of the request to netconfigd (all arguments). */
+static constexpr size_t maxRequestSize = 64 * 1024;
+
+/** @brief Max size of the output chunk in a single reply packet. */
+static constexpr size_t maxChunkSize = 16 * 1024;
+
+/**
+ * @brief Type of the netconfigd reply packet, the first byte of the packet.
+ *
+ * The daemon sends `ready` as soon as it starts serving the connection, the
+ * client sends its request only after that. Output of the command follows
+ * in `out` and `err` chunks, the last packet is `status`.
+ */
+enum class Reply : uint8_t
+{
+    /** @brief Daemon is ready to execute the request. */
+    ready,
+    /** @brief Chunk of the command's stdout. */
+    out,
+    /** @brief Chunk of the command's stderr. */
+    err,
+    /** @brief Exit status of the command, int32_t. */
+    status
+};
+
+/**
+ * @brief Execute the configuration command by netconfigd daemon.
+ *        The daemon collects the command output and sends it back over the
+ *        socket, it is printed to our stdout and stderr.
+ *
+ * @param[in] app  application name
+ * @param[in] args command line arguments
+ * @param[out] status exit status of the command
+ *
+ * @throw std::exception if connection to the daemon is lost
+ *
+ * @return false if daemon is not available or busy, nothing has been sent
+ *         to it in this case
+ */
+bool executeRemote(const char* app, const Arguments& args, int& status);
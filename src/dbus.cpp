@@ -3,30 +3,508 @@
 
 #include "dbus.hpp"
 
+#include "objcache.hpp"
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <sdbusplus/exception.hpp>
+
+#include <cerrno>
+#include <limits>
+#include <optional>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+struct Dbus::AsyncCall
+{
+    AsyncCall(Dbus& owner, ReplyHandler&& handler, ErrorHandler&& onError,
+              const char* service, const char* object, const char* interface,
+              const char* name) :
+        owner(owner),
+        handler(std::move(handler)), onError(std::move(onError)),
+        service(service), object(object), interface(interface), name(name)
+    {
+        stat.emplace(this->service.c_str(), this->object.c_str(),
+                     this->interface.c_str(), this->name.c_str(), true);
+    }
+
+    ~AsyncCall()
+    {
+        sd_bus_slot_unref(slot);
+    }
+
+    AsyncCall(const AsyncCall&) = delete;
+    AsyncCall& operator=(const AsyncCall&) = delete;
+
+    /** @brief D-Bus wrapper that sent the call. */
+    Dbus& owner;
+    /** @brief Reply handler. */
+    ReplyHandler handler;
+    /** @brief Error handler. */
+    ErrorHandler onError;
+    /** @brief Method description, the caller's strings may not outlive the
+     *         call. */
+    std::string service;
+    std::string object;
+    std::string interface;
+    std::string name;
+    /** @brief Round trip statistics, reset when the reply is received. */
+    std::optional<Stats::Call> stat;
+    /** @brief sd-bus slot of the pending reply. */
+    sd_bus_slot* slot = nullptr;
+    /** @brief Flag: the reply has been handled. */
+    bool done = false;
+};
+
+Dbus::Dbus() = default;
 
-Dbus::Dbus() : bus(sdbusplus::bus::new_default())
+Dbus::Dbus(Networkd& networkd) : networkd(&networkd)
 {}
 
+Dbus::~Dbus() = default;
+
+sdbusplus::bus::bus& Dbus::connection()
+{
+    if (networkd)
+    {
+        throw std::runtime_error(
+            "The network service can not be used in the offline mode");
+    }
+    if (!bus)
+    {
+        Stats::Timer timer(Stats::connect);
+        bus.emplace(sdbusplus::bus::new_default());
+    }
+    return *bus;
+}
+
+void Dbus::enableCache()
+{
+    if (!cache)
+    {
+        cache = std::make_unique<ObjectCache>(connection());
+    }
+}
+
+void Dbus::observeCache(std::function<void(const std::string& path)> handler)
+{
+    enableCache();
+    cache->setObserver(std::move(handler));
+}
+
+std::optional<Dbus::ManagedObject> Dbus::readSnapshot() const
+{
+    if (cache || networkd)
+    {
+        return std::nullopt;
+    }
+    return Snapshot::read(NETCONFIG_SNAPSHOT);
+}
+
+const Dbus::ManagedObject& Dbus::cachedObjects() const
+{
+    if (!cache)
+    {
+        throw std::logic_error("Objects cache is not enabled");
+    }
+    return cache->objects();
+}
+
+void Dbus::process()
+{
+    while (connection().process_discard())
+    {
+    }
+}
+
+std::tuple<int, short> Dbus::getPollFd()
+{
+    const int events = sd_bus_get_events(connection().get());
+    return std::make_tuple(connection().get_fd(),
+                           static_cast<short>(events < 0 ? POLLIN : events));
+}
+
+void Dbus::wait(uint64_t timeout)
+{
+    connection().wait(timeout);
+    process();
+}
+
+void Dbus::send(sdbusplus::message::message& mcall, ReplyHandler&& handler,
+                ErrorHandler&& onError, const char* service, const char* object,
+                const char* interface, const char* name)
+{
+    if (asyncPending >= maxAsyncCalls)
+    {
+        waitPending(maxAsyncCalls - 1);
+    }
+
+    AsyncCall& call = asyncCalls.emplace_back(*this, std::move(handler),
+                                              std::move(onError), service,
+                                              object, interface, name);
+    const int rc =
+        sd_bus_call_async(connection().get(), &call.slot, mcall.get(),
+                          &Dbus::asyncReply, &call, 0);
+    if (rc < 0)
+    {
+        call.stat->fail();
+        asyncCalls.pop_back();
+        throw sdbusplus::exception::SdBusError(-rc, "sd_bus_call_async");
+    }
+    ++asyncPending;
+}
+
+int Dbus::asyncReply(sd_bus_message* reply, void* userdata,
+                     sd_bus_error* /*error*/)
+{
+    AsyncCall& call = *static_cast<AsyncCall*>(userdata);
+    Dbus& owner = call.owner;
+    call.done = true;
+    --owner.asyncPending;
+
+    // Exceptions must not cross sd-bus, they are rethrown by waitAll()
+    try
+    {
+        if (sd_bus_message_is_method_error(reply, nullptr))
+        {
+            call.stat->fail();
+            call.stat.reset();
+            sd_bus_error err = SD_BUS_ERROR_NULL;
+            sd_bus_error_copy(&err, sd_bus_message_get_error(reply));
+            throw sdbusplus::exception::SdBusError(&err, call.name.c_str());
+        }
+        call.stat.reset();
+        if (call.handler)
+        {
+            sdbusplus::message::message msg(reply);
+            call.handler(msg);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        try
+        {
+            if (!call.onError)
+            {
+                throw;
+            }
+            call.onError(ex);
+        }
+        catch (...)
+        {
+            if (!owner.asyncError)
+            {
+                owner.asyncError = std::current_exception();
+            }
+        }
+    }
+
+    return 0;
+}
+
+void Dbus::waitPending(size_t max)
+{
+    process();
+    while (asyncPending > max)
+    {
+        {
+            // Wall time of waiting for replies, durations of overlapping
+            // calls can't be summed
+            Stats::Timer timer(Stats::call);
+            connection().wait(std::numeric_limits<uint64_t>::max());
+        }
+        process();
+    }
+    asyncCalls.remove_if([](const AsyncCall& call) { return call.done; });
+}
+
+void Dbus::waitAll()
+{
+    waitPending(0);
+
+    if (asyncError)
+    {
+        std::exception_ptr error;
+        std::swap(error, asyncError);
+        std::rethrow_exception(error);
+    }
+}
+
+void Dbus::cancelAll() noexcept
+{
+    for (auto& call : asyncCalls)
+    {
+        if (call.stat)
+        {
+            call.stat->fail();
+        }
+    }
+    // Unreferenced slot drops the pending reply callback
+    asyncCalls.clear();
+    asyncPending = 0;
+    asyncError = nullptr;
+}
+
+sdbusplus::bus::match::match
+    Dbus::subscribe(const std::string& rule,
+                    sdbusplus::bus::match::match::callback_t handler)
+{
+    return sdbusplus::bus::match::match(connection(), rule, std::move(handler));
+}
+
+Dbus::ManagedObject Dbus::getManagedObjects(const Interfaces& interfaces)
+{
+    if (cache)
+    {
+        return cache->objects();
+    }
+    ManagedObject objects;
+    auto reply = call(networkService, objectRoot, objmgrInterface, objmgrGet);
+    Stats::Timer timer(Stats::decode);
+    readManagedObjects(reply, interfaces, objects);
+    return objects;
+}
+
+void Dbus::getManagedObjectsAsync(const Interfaces& interfaces,
+                                  ManagedObject& objects)
+{
+    if (cache)
+    {
+        objects = cache->objects();
+        return;
+    }
+    callAsync(
+        [&interfaces, &objects](sdbusplus::message::message& reply) {
+            Stats::Timer timer(Stats::decode);
+            readManagedObjects(reply, interfaces, objects);
+        },
+        networkService, objectRoot, objmgrInterface, objmgrGet);
+}
+
+/**
+ * @brief Check the result of sd-bus function.
+ *
+ * @param[in] rc returned value
+ * @param[in] func function name
+ *
+ * @throw sdbusplus::exception::SdBusError if function failed
+ *
+ * @return returned value
+ */
+static int check(int rc, const char* func)
+{
+    if (rc < 0)
+    {
+        throw sdbusplus::exception::SdBusError(-rc, func);
+    }
+    return rc;
+}
+
+void Dbus::readManagedObjects(sdbusplus::message::message& reply,
+                              const Interfaces& interfaces,
+                              ManagedObject& objects)
+{
+    sd_bus_message* msg = reply.get();
+
+    // a{oa{sa{sv}}}
+    check(sd_bus_message_enter_container(msg, SD_BUS_TYPE_ARRAY,
+                                         "{oa{sa{sv}}}"),
+          "sd_bus_message_enter_container");
+    while (check(sd_bus_message_enter_container(msg, SD_BUS_TYPE_DICT_ENTRY,
+                                                "oa{sa{sv}}"),
+                 "sd_bus_message_enter_container") > 0)
+    {
+        const char* path;
+        check(sd_bus_message_read_basic(msg, SD_BUS_TYPE_OBJECT_PATH, &path),
+              "sd_bus_message_read_basic");
+
+        ManagedObject::mapped_type* object = nullptr;
+
+        check(sd_bus_message_enter_container(msg, SD_BUS_TYPE_ARRAY,
+                                             "{sa{sv}}"),
+              "sd_bus_message_enter_container");
+        while (check(sd_bus_message_enter_container(
+                         msg, SD_BUS_TYPE_DICT_ENTRY, "sa{sv}"),
+                     "sd_bus_message_enter_container") > 0)
+        {
+            const char* name;
+            check(sd_bus_message_read_basic(msg, SD_BUS_TYPE_STRING, &name),
+                  "sd_bus_message_read_basic");
+
+            const bool wanted =
+                interfaces.empty() ||
+                std::find_if(interfaces.begin(), interfaces.end(),
+                             [name](const char* iface) {
+                                 return strcmp(iface, name) == 0;
+                             }) != interfaces.end();
+            if (wanted)
+            {
+                if (!object)
+                {
+                    object = &objects[path];
+                }
+                reply.read((*object)[name]);
+            }
+            else
+            {
+                check(sd_bus_message_skip(msg, "a{sv}"),
+                      "sd_bus_message_skip");
+            }
+
+            check(sd_bus_message_exit_container(msg),
+                  "sd_bus_message_exit_container");
+        }
+        check(sd_bus_message_exit_container(msg),
+              "sd_bus_message_exit_container");
+
+        check(sd_bus_message_exit_container(msg),
+              "sd_bus_message_exit_container");
+    }
+    check(sd_bus_message_exit_container(msg), "sd_bus_message_exit_container");
+}
+
+Dbus::Properties Dbus::getAll(const char* service, const char* object,
+                              const char* interface)
+{
+    Properties properties;
+    auto reply =
+        call(service, object, propertiesInterface, propertiesGetAll, interface);
+    Stats::Timer timer(Stats::decode);
+    reply.read(properties);
+    return properties;
+}
+
+std::tuple<std::string, uint16_t> Dbus::getSyslog()
+{
+    return readSyslog(getAll(syslogService, objectSyslog, syslogInterface));
+}
+
+void Dbus::getSyslogAsync(std::tuple<std::string, uint16_t>& syslog)
+{
+    callAsync(
+        [&syslog](sdbusplus::message::message& reply) {
+            Stats::Timer timer(Stats::decode);
+            Properties props;
+            reply.read(props);
+            syslog = readSyslog(props);
+        },
+        syslogService, objectSyslog, propertiesInterface, propertiesGetAll,
+        syslogInterface);
+}
+
+std::tuple<std::string, uint16_t> Dbus::readSyslog(const Properties& props)
+{
+    std::string address;
+    uint16_t port = 0;
+    auto it = props.find(syslogAddr);
+    if (it != props.end() && std::holds_alternative<std::string>(it->second))
+    {
+        address = std::get<std::string>(it->second);
+    }
+    it = props.find(syslogPort);
+    if (it != props.end() && std::holds_alternative<uint16_t>(it->second))
+    {
+        port = std::get<uint16_t>(it->second);
+    }
+
+    return std::make_tuple(address, port);
+}
+
+size_t Dbus::setSyslog(const std::string& address, uint16_t port)
+{
+    const auto [curAddress, curPort] = getSyslog();
+    const bool setAddress = curAddress != address;
+    const bool setPort = curPort != port;
+
+    // While the address is empty forwarding is disabled, so the port is
+    // changed only then: first when enabling forwarding, last when
+    // disabling it. If both the address and the port of an enabled server
+    // change, forwarding is disabled for the switch, that costs one more
+    // restart of the syslog service but never sends logs to the new
+    // address with the old port. Every call is sent only after the
+    // previous one has succeeded.
+    bool disabled = curAddress.empty();
+    if (setAddress && setPort && !disabled && !address.empty())
+    {
+        set(syslogService, objectSyslog, syslogInterface, syslogAddr,
+            std::string());
+        disabled = true;
+    }
+    if (setPort && disabled)
+    {
+        set(syslogService, objectSyslog, syslogInterface, syslogPort, port);
+    }
+    if (setAddress)
+    {
+        set(syslogService, objectSyslog, syslogInterface, syslogAddr, address);
+    }
+    if (setPort && !disabled)
+    {
+        set(syslogService, objectSyslog, syslogInterface, syslogPort, port);
+    }
+
+    return setAddress + setPort;
+}
+
+/**
+ * @class EditLock
+ * @brief Exclusive advisory lock held while editing property array.
+ *        The lock is skipped if the lock file can not be opened (e.g. run
+ *        by unprivileged user), that only brings back the race.
+ */
+class EditLock
+{
+  public:
+    EditLock() : fd(open(NETCONFIG_LOCK, O_RDWR | O_CREAT | O_CLOEXEC, 0600))
+    {
+        while (fd != -1 && flock(fd, LOCK_EX) == -1 && errno == EINTR)
+        {
+        }
+    }
+
+    ~EditLock()
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+
+    EditLock(const EditLock&) = delete;
+    EditLock& operator=(const EditLock&) = delete;
+
+  private:
+    /** @brief Lock file descriptor, the lock is released on close. */
+    int fd;
+};
+
 void Dbus::append(const char* service, const char* object,
                   const char* interface, const char* name,
                   const std::vector<std::string>& values)
 {
+    EditLock lock;
+
     auto array =
         get<std::vector<std::string>>(service, object, interface, name);
-    bool needUpdate = false;
+    const size_t size = array.size();
 
+    // The views stay valid as the array doesn't grow beyond reserved size
+    array.reserve(size + values.size());
+    std::unordered_set<std::string_view> present(array.begin(), array.end());
     for (const auto& value : values)
     {
-        const auto it = std::find(array.begin(), array.end(), value);
-        if (it == array.end())
+        if (present.insert(value).second)
         {
             array.push_back(value);
-            needUpdate = true;
         }
     }
 
-    if (!needUpdate)
+    if (array.size() == size)
     {
         throw std::invalid_argument("No new values specified");
     }
@@ -38,61 +516,107 @@ void Dbus::remove(const char* service, const char* object,
                   const char* interface, const char* name,
                   const std::vector<std::string>& values)
 {
+    EditLock lock;
+
     auto array =
         get<std::vector<std::string>>(service, object, interface, name);
-    bool needUpdate = false;
 
-    for (const auto& value : values)
-    {
-        const auto it = std::find(array.begin(), array.end(), value);
-        if (it != array.end())
-        {
-            array.erase(it);
-            needUpdate = true;
-        }
-    }
-
-    if (!needUpdate)
+    const std::unordered_set<std::string_view> drop(values.begin(),
+                                                    values.end());
+    const auto end =
+        std::remove_if(array.begin(), array.end(),
+                       [&drop](const std::string& v) { return drop.count(v); });
+    if (end == array.end())
     {
         throw std::invalid_argument("No values to remove found");
     }
+    array.erase(end, array.end());
 
     set(service, object, interface, name, array);
 }
 
 std::vector<Dbus::IpAddress> Dbus::getAddresses(const char* ethObject)
+{
+    return getAddresses(ethObject, getManagedObjects({ipInterface}));
+}
+
+std::vector<Dbus::IpAddress> Dbus::getAddresses(const char* ethObject,
+                                                const ManagedObject& objects)
 {
     std::vector<IpAddress> addresses;
 
     std::string pathPrefix = ethObject;
     pathPrefix += "/ip";
 
-    Dbus::ManagedObject objects;
-    call(networkService, objectRoot, objmgrInterface, objmgrGet).read(objects);
-
-    for (const auto& it : objects)
+    // Objects are sorted by path, so all addresses of the interface are
+    // placed in a row starting from the prefix
+    for (auto it = objects.lower_bound(pathPrefix); it != objects.end(); ++it)
     {
-        const std::string& path = it.first;
-        if (path.compare(0, pathPrefix.length(), pathPrefix) == 0)
+        const std::string& path = it->first;
+        if (path.compare(0, pathPrefix.length(), pathPrefix) != 0)
+        {
+            break;
+        }
+        const auto ip = it->second.find(Dbus::ipInterface);
+        if (ip != it->second.end())
         {
-            const auto ip = it.second.find(Dbus::ipInterface);
-            if (ip != it.second.end())
+            const auto& ipProperties = ip->second;
+            const auto address = IpAddr::parse(
+                std::get<std::string>(ipProperties.find(ipAddress)->second)
+                    .c_str());
+            if (!address)
+            {
+                continue;
+            }
+            IpAddress addr = {
+                path,
+                *address,
+                std::get<uint8_t>(ipProperties.find(ipPrefix)->second),
+                std::get<std::string>(ipProperties.find(ipGateway)->second),
+                std::string(),
+            };
+            const auto origin = ipProperties.find(ipOrigin);
+            if (origin != ipProperties.end() &&
+                std::holds_alternative<std::string>(origin->second))
             {
-                const auto& ipProperties = ip->second;
-                IpAddress addr = {
-                    path,
-                    std::get<std::string>(ipProperties.find(ipAddress)->second),
-                    std::get<uint8_t>(ipProperties.find(ipPrefix)->second),
-                    std::get<std::string>(ipProperties.find(ipGateway)->second),
-                };
-                addresses.emplace_back(addr);
+                addr.origin = std::get<std::string>(origin->second);
             }
+            addresses.emplace_back(addr);
         }
     }
 
     return addresses;
 }
 
+std::string Dbus::ethObject(const char* name)
+{
+    std::string object = ethToPath(name);
+    if (cache)
+    {
+        const auto& objects = cache->objects();
+        const auto it = objects.find(object);
+        if (it == objects.end() ||
+            it->second.find(ethInterface) == it->second.end())
+        {
+            std::string err = "Network interface ";
+            err += name;
+            err += " is not managed by the network service";
+            throw std::invalid_argument(err);
+        }
+    }
+    return object;
+}
+
+const char* Dbus::shortEnum(const std::string& value)
+{
+    static const char enumPrefix[] = "xyz.openbmc_project.";
+    if (value.compare(0, sizeof(enumPrefix) - 1, enumPrefix) == 0)
+    {
+        return value.c_str() + value.rfind('.') + 1;
+    }
+    return value.c_str();
+}
+
 std::string Dbus::ethToPath(const char* name)
 {
     std::string dbusName = name;
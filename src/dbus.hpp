@@ -4,8 +4,20 @@
 #pragma once
 
 #include "config.hpp"
+#include "ipaddr.hpp"
+#include "stats.hpp"
 
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+
+class Networkd;
+class ObjectCache;
 
 /**
  * @class Dbus
@@ -77,6 +89,13 @@ class Dbus
     static constexpr const char* ipAddress = "Address";
     static constexpr const char* ipGateway = "Gateway";
     static constexpr const char* ipPrefix = "PrefixLength";
+    static constexpr const char* ipOrigin = "Origin";
+    static constexpr const char* ipOriginStatic =
+        "xyz.openbmc_project.Network.IP.AddressOrigin.Static";
+    static constexpr const char* ipOriginDhcp =
+        "xyz.openbmc_project.Network.IP.AddressOrigin.DHCP";
+    static constexpr const char* ipOriginLinkLocal =
+        "xyz.openbmc_project.Network.IP.AddressOrigin.LinkLocal";
 
     // IP version interfaces
     static constexpr const char* ip4Interface =
@@ -98,17 +117,26 @@ class Dbus
     static constexpr const char* propertiesInterface =
         "org.freedesktop.DBus.Properties";
     static constexpr const char* propertiesGet = "Get";
+    static constexpr const char* propertiesGetAll = "GetAll";
     static constexpr const char* propertiesSet = "Set";
 
     // Object manager interface, its methods and typedefs
     static constexpr const char* objmgrInterface =
         "org.freedesktop.DBus.ObjectManager";
     static constexpr const char* objmgrGet = "GetManagedObjects";
-    using PropertyValue = std::variant<uint8_t, uint32_t, bool, std::string,
-                                       std::vector<std::string>>;
+    using PropertyValue =
+        std::variant<uint8_t, uint16_t, uint32_t, bool, std::string,
+                     std::vector<std::string>>;
     using Properties = std::map<std::string, PropertyValue>;
     using ManagedObject = std::map<sdbusplus::message::object_path,
                                    std::map<std::string, Properties>>;
+    using Interfaces = std::vector<const char*>;
+    using ReplyHandler = std::function<void(sdbusplus::message::message&)>;
+    using ErrorHandler = std::function<void(const std::exception&)>;
+
+    /** @brief Max number of asynchronous calls in flight, the system bus
+     *         limits pending replies per connection (128 by default). */
+    static constexpr size_t maxAsyncCalls = 64;
 
     // Remote syslog server interface, its methods and properties
     static constexpr const char* syslogInterface =
@@ -119,6 +147,146 @@ class Dbus
     /** @brief Constructor. */
     Dbus();
 
+    /**
+     * @brief Constructor for the offline mode: commands edit the files
+     *        persisted by the network service, see offline(). D-Bus is never
+     *        connected, any attempt to use it fails.
+     *
+     * @param[in] networkd offline configuration backend
+     */
+    explicit Dbus(Networkd& networkd);
+
+    /** @brief Destructor. */
+    ~Dbus();
+
+    /**
+     * @brief Get offline configuration backend.
+     *
+     * @return backend or nullptr if the network service is used
+     */
+    Networkd* offline() const
+    {
+        return networkd;
+    }
+
+    /**
+     * @brief Enable local mirror of network objects.
+     *        The mirror is updated by D-Bus signals, see process().
+     *
+     * @throw std::exception in case of errors
+     */
+    void enableCache();
+
+    /**
+     * @brief Read the network objects snapshot published by netconfigd in
+     *        shared memory without any D-Bus traffic. The snapshot is never
+     *        kept: it may lag behind the network service a little, so only
+     *        read commands should render it, and never as a base for edits.
+     *
+     * @return network objects or nothing if the snapshot is missing or
+     *         stale, or the local mirror is enabled (it is always up to date)
+     */
+    std::optional<ManagedObject> readSnapshot() const;
+
+    /**
+     * @brief Set handler of the local mirror changes, enables the mirror.
+     *
+     * @param[in] handler called with path to the changed object, empty path
+     *                    means the whole tree has been reloaded
+     *
+     * @throw std::exception in case of errors
+     */
+    void observeCache(std::function<void(const std::string& path)> handler);
+
+    /**
+     * @brief Get local mirror of network objects without copying it.
+     *        The mirror changes while D-Bus signals are handled.
+     *
+     * @throw std::logic_error if the mirror is not enabled
+     *
+     * @return network objects
+     */
+    const ManagedObject& cachedObjects() const;
+
+    /**
+     * @brief Handle all pending D-Bus messages (signals) without blocking.
+     *
+     * @throw std::exception in case of errors
+     */
+    void process();
+
+    /**
+     * @brief Get D-Bus connection file descriptor and events to poll for.
+     *
+     * @return file descriptor and poll events mask
+     */
+    std::tuple<int, short> getPollFd();
+
+    /**
+     * @brief Wait for D-Bus events and handle them.
+     *
+     * @param[in] timeout max time to wait in microseconds
+     *
+     * @throw std::exception in case of errors
+     */
+    void wait(uint64_t timeout);
+
+    /**
+     * @brief Subscribe to D-Bus signal.
+     *        Signals are handled by process() and wait().
+     *
+     * @param[in] rule match rule
+     * @param[in] handler signal handler
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return subscription, signals are handled while it exists
+     */
+    sdbusplus::bus::match::match
+        subscribe(const std::string& rule,
+                  sdbusplus::bus::match::match::callback_t handler);
+
+    /**
+     * @brief Get all network objects: from the local mirror if it is enabled,
+     *        otherwise from the network service.
+     *
+     * @param[in] interfaces list of interfaces to get, others are skipped
+     *                       while decoding the reply (empty list means all),
+     *                       objects without such interfaces are omitted;
+     *                       the local mirror is returned as is
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return network objects
+     */
+    ManagedObject getManagedObjects(const Interfaces& interfaces = {});
+
+    /**
+     * @brief Asynchronous version of getManagedObjects(), the result is
+     *        ready after waitAll().
+     *
+     * @param[in] interfaces list of interfaces to get
+     * @param[out] objects network objects
+     *
+     * @throw std::exception in case of errors
+     */
+    void getManagedObjectsAsync(const Interfaces& interfaces,
+                                ManagedObject& objects);
+
+    /**
+     * @brief Decode GetManagedObjects reply keeping only specified interfaces.
+     *        Skipped interfaces are not materialized.
+     *
+     * @param[in] reply reply message
+     * @param[in] interfaces list of interfaces to keep, empty list means all
+     * @param[out] objects decoded objects
+     *
+     * @throw std::exception in case of errors
+     */
+    static void readManagedObjects(sdbusplus::message::message& reply,
+                                   const Interfaces& interfaces,
+                                   ManagedObject& objects);
+
     /**
      * @brief Call network manager's method via D-Bus.
      *
@@ -135,11 +303,110 @@ class Dbus
     auto call(const char* service, const char* object, const char* interface,
               const char* name, T&&... args)
     {
-        auto mcall = bus.new_method_call(service, object, interface, name);
+        auto mcall =
+            connection().new_method_call(service, object, interface, name);
+        mcall.append(std::forward<T>(args)...);
+        Stats::Call stat(service, object, interface, name);
+        return connection().call(mcall);
+    }
+
+    /**
+     * @brief Send method call without waiting for the reply.
+     *        Up to maxAsyncCalls can be in flight on the connection (sending
+     *        more waits for the earlier ones), replies are handled in order
+     *        of their arrival by waitAll().
+     *
+     * @param[in] handler reply handler, may be empty
+     * @param[in] object D-Bus object path
+     * @param[in] interface interface name
+     * @param[in] name method name
+     * @param[in] ... method parameters
+     *
+     * @throw std::exception if the call can not be sent
+     */
+    template <typename... T>
+    void callAsync(ReplyHandler handler, const char* service,
+                   const char* object, const char* interface, const char* name,
+                   T&&... args)
+    {
+        callAsync(std::move(handler), ErrorHandler(), service, object,
+                  interface, name, std::forward<T>(args)...);
+    }
+
+    /**
+     * @brief Send method call without waiting for the reply, errors are
+     *        passed to the error handler instead of waitAll().
+     *
+     * @param[in] handler reply handler, may be empty
+     * @param[in] onError error handler, called if the call fails or the
+     *                    reply handler throws, may be empty
+     * @param[in] object D-Bus object path
+     * @param[in] interface interface name
+     * @param[in] name method name
+     * @param[in] ... method parameters
+     *
+     * @throw std::exception if the call can not be sent
+     */
+    template <typename... T>
+    void callAsync(ReplyHandler handler, ErrorHandler onError,
+                   const char* service, const char* object,
+                   const char* interface, const char* name, T&&... args)
+    {
+        auto mcall =
+            connection().new_method_call(service, object, interface, name);
         mcall.append(std::forward<T>(args)...);
-        return bus.call(mcall);
+        send(mcall, std::move(handler), std::move(onError), service, object,
+             interface, name);
     }
 
+    /**
+     * @brief Wait for replies to all calls sent with callAsync().
+     *
+     * @throw std::exception the first error returned by the calls or thrown
+     *                       by the reply handlers
+     */
+    void waitAll();
+
+    /**
+     * @brief Cancel all calls sent with callAsync() that are still waiting
+     *        for the reply, their handlers are never called. The pending
+     *        error is dropped too.
+     */
+    void cancelAll() noexcept;
+
+    /**
+     * @class AsyncScope
+     * @brief Cancels asynchronous calls still pending when leaving the scope.
+     *
+     * Reply handlers usually refer to the caller's stack. If an exception
+     * leaves the scope before waitAll(), the calls must not be completed
+     * later by another user of the same connection (shell, batch mode,
+     * daemon).
+     */
+    class AsyncScope
+    {
+      public:
+        /**
+         * @brief Constructor.
+         *
+         * @param[in] bus D-Bus instance
+         */
+        explicit AsyncScope(Dbus& bus) : bus(bus)
+        {}
+
+        ~AsyncScope()
+        {
+            bus.cancelAll();
+        }
+
+        AsyncScope(const AsyncScope&) = delete;
+        AsyncScope& operator=(const AsyncScope&) = delete;
+
+      private:
+        /** @brief D-Bus instance. */
+        Dbus& bus;
+    };
+
     /**
      * @brief Get property value.
      *
@@ -156,12 +423,26 @@ class Dbus
           const char* name)
     {
         std::variant<T> value;
-        call(service, object, propertiesInterface, propertiesGet, interface,
-             name)
-            .read(value);
+        auto reply = call(service, object, propertiesInterface, propertiesGet,
+                          interface, name);
+        Stats::Timer timer(Stats::decode);
+        reply.read(value);
         return std::get<T>(value);
     }
 
+    /**
+     * @brief Get all properties of the interface.
+     *
+     * @param[in] object path to D-Bus object
+     * @param[in] interface interface name
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return properties
+     */
+    Properties getAll(const char* service, const char* object,
+                      const char* interface);
+
     /**
      * @brief Set property value.
      *
@@ -182,6 +463,9 @@ class Dbus
 
     /**
      * @brief Append string value to property array.
+     *        Read-modify-write of the array is serialized between netconfig
+     *        processes with the lock file, so concurrent edits don't lose
+     *        updates.
      *
      * @param[in] object path to D-Bus object
      * @param[in] interface property's interface name
@@ -196,6 +480,7 @@ class Dbus
 
     /**
      * @brief Remove string value from property array.
+     *        Serialized in the same way as append().
      *
      * @param[in] object path to D-Bus object
      * @param[in] interface property's interface name
@@ -208,6 +493,42 @@ class Dbus
     void remove(const char* service, const char* object, const char* interface,
                 const char* name, const std::vector<std::string>& values);
 
+    /**
+     * @brief Get remote syslog server settings with a single request.
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return server address (empty if not set) and port
+     */
+    std::tuple<std::string, uint16_t> getSyslog();
+
+    /**
+     * @brief Asynchronous version of getSyslog(), the result is ready after
+     *        waitAll().
+     *
+     * @param[out] syslog server address (empty if not set) and port
+     *
+     * @throw std::exception in case of errors
+     */
+    void getSyslogAsync(std::tuple<std::string, uint16_t>& syslog);
+
+    /**
+     * @brief Set remote syslog server.
+     *        Every property change makes the syslog service rewrite rsyslog
+     *        configuration and restart it, so only changed properties are
+     *        set and in the order that never enables forwarding to the
+     *        mix of the old and new settings: the port is changed only
+     *        while forwarding is disabled.
+     *
+     * @param[in] address server address, empty to disable forwarding
+     * @param[in] port server port
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return number of changed properties
+     */
+    size_t setSyslog(const std::string& address, uint16_t port);
+
     /**
      * @struct IpAddress
      * @brief Description of IP address.
@@ -217,11 +538,13 @@ class Dbus
         /** @brief D-Bus path to the IP object. */
         std::string object;
         /** @brief IP address. */
-        std::string address;
+        IpAddr address;
         /** @brief Mask bits. */
         uint8_t mask;
         /** @brief Gateway IP. */
         std::string gateway;
+        /** @brief Address origin (static, DHCP, etc), empty if unknown. */
+        std::string origin;
     };
 
     /**
@@ -233,6 +556,43 @@ class Dbus
      */
     std::vector<IpAddress> getAddresses(const char* ethObject);
 
+    /**
+     * @brief Get list of IP addresses for specified Ethernet object
+     *        from the already fetched set of network objects.
+     *
+     * @param[in] ethObject path to Ethernet object (eth0 or VLAN)
+     * @param[in] objects network objects (result of GetManagedObjects)
+     *
+     * @return array with IP addresses description
+     */
+    static std::vector<IpAddress> getAddresses(const char* ethObject,
+                                               const ManagedObject& objects);
+
+    /**
+     * @brief Get D-Bus object path of the network interface managed by the
+     *        network service. Existence of the object is checked with the
+     *        local mirror if it is enabled, otherwise it is left to the
+     *        following D-Bus call to avoid an extra round trip.
+     *
+     * @param[in] name network interface name
+     *
+     * @throw std::invalid_argument if interface is not managed
+     *
+     * @return path to D-Bus object
+     */
+    std::string ethObject(const char* name);
+
+    /**
+     * @brief Strip the type name prefix from D-Bus enumeration value, e.g.
+     *        `xyz.openbmc_project.Network.IP.AddressOrigin.Static` becomes
+     *        `Static`.
+     *
+     * @param[in] value property value
+     *
+     * @return enumeration value name or the value as is if it isn't enum
+     */
+    static const char* shortEnum(const std::string& value);
+
     /**
      * @brief Convert network interface name to its D-Bus object path.
      *
@@ -243,6 +603,75 @@ class Dbus
     static std::string ethToPath(const char* name);
 
   private:
-    /** @brief D-Bus connection. */
-    sdbusplus::bus::bus bus;
+    /** @brief Asynchronous method call in flight. */
+    struct AsyncCall;
+
+    /**
+     * @brief Send method call message asynchronously.
+     *
+     * @param[in] mcall method call message
+     * @param[in] handler reply handler, may be empty
+     * @param[in] onError error handler, may be empty
+     * @param[in] ... method description for statistics
+     *
+     * @throw std::exception if the call can not be sent
+     */
+    void send(sdbusplus::message::message& mcall, ReplyHandler&& handler,
+              ErrorHandler&& onError, const char* service, const char* object,
+              const char* interface, const char* name);
+
+    /**
+     * @brief Wait until no more than specified number of asynchronous calls
+     *        are in flight and release the completed ones.
+     *
+     * @param[in] max max number of calls in flight
+     *
+     * @throw std::exception in case of errors
+     */
+    void waitPending(size_t max);
+
+    /**
+     * @brief Reply callback of sd_bus_call_async().
+     *
+     * @param[in] reply reply message
+     * @param[in] userdata pointer to AsyncCall instance
+     *
+     * @return 0, errors are saved for waitAll()
+     */
+    static int asyncReply(sd_bus_message* reply, void* userdata,
+                          sd_bus_error* error);
+
+    /**
+     * @brief Get D-Bus connection, connect if not connected yet.
+     *        Commands that don't use D-Bus never connect.
+     *
+     * @throw std::runtime_error in the offline mode
+     * @throw std::exception in case of errors
+     *
+     * @return D-Bus connection
+     */
+    sdbusplus::bus::bus& connection();
+
+    /**
+     * @brief Decode remote syslog server settings.
+     *
+     * @param[in] props properties of the syslog interface
+     *
+     * @return server address (empty if not set) and port
+     */
+    static std::tuple<std::string, uint16_t>
+        readSyslog(const Properties& props);
+
+    /** @brief D-Bus connection, established on the first use. */
+    std::optional<sdbusplus::bus::bus> bus;
+    /** @brief Offline configuration backend, see offline(). */
+    Networkd* networkd = nullptr;
+    /** @brief Local mirror of network objects. */
+    std::unique_ptr<ObjectCache> cache;
+    /** @brief Asynchronous calls in flight. */
+    std::list<AsyncCall> asyncCalls;
+    /** @brief Number of asynchronous calls waiting for the reply. */
+    size_t asyncPending = 0;
+    /** @brief The first error of asynchronous calls. */
+    std::exception_ptr asyncError;
 };
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "drift.hpp"
+
+#include "kernel.hpp"
+
+#include <strings.h>
+
+#include <map>
+#include <stdexcept>
+
+/**
+ * @struct IfaceState
+ * @brief Programmed configuration of the network interface.
+ */
+struct IfaceState
+{
+    /** @brief MAC address, empty if unknown. */
+    std::string mac;
+    /** @brief VLAN Id, 0 if not a VLAN. */
+    uint32_t vlan = 0;
+    /** @brief IP addresses with their prefixes. */
+    std::map<IpAddr, uint8_t> addresses;
+};
+
+/**
+ * @brief Get numeric property value.
+ *
+ * @param[in] properties array of properties
+ * @param[in] name property name
+ *
+ * @return property value, 0 if not found or not a number
+ */
+static uint32_t getNumber(const Dbus::Properties& properties, const char* name)
+{
+    const auto it = properties.find(name);
+    if (it == properties.end())
+    {
+        return 0;
+    }
+    return std::visit(
+        [](auto&& arg) -> uint32_t {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_arithmetic<T>::value)
+            {
+                return static_cast<uint32_t>(arg);
+            }
+            else
+            {
+                return 0;
+            }
+        },
+        it->second);
+}
+
+/**
+ * @brief Get string property value.
+ *
+ * @param[in] properties array of properties
+ * @param[in] name property name
+ *
+ * @return property value, empty if not found or not a string
+ */
+static std::string getString(const Dbus::Properties& properties,
+                             const char* name)
+{
+    const auto it = properties.find(name);
+    if (it != properties.end())
+    {
+        if (const auto* str = std::get_if<std::string>(&it->second))
+        {
+            return *str;
+        }
+    }
+    return std::string();
+}
+
+/**
+ * @brief Collect programmed configuration of all network interfaces.
+ *
+ * @param[in] objects network objects
+ *
+ * @return interface name to its configuration
+ */
+static std::map<std::string, IfaceState>
+    collect(const Dbus::ManagedObject& objects)
+{
+    static const Dbus::Properties empty;
+    const auto getProperties =
+        [](const std::map<std::string, Dbus::Properties>& interfaces,
+           const char* name) -> const Dbus::Properties& {
+        const auto it = interfaces.find(name);
+        return it == interfaces.end() ? empty : it->second;
+    };
+
+    std::map<std::string, IfaceState> ifaces;
+    for (const auto& [path, interfaces] : objects)
+    {
+        const auto eth = interfaces.find(Dbus::ethInterface);
+        if (eth == interfaces.end())
+        {
+            continue;
+        }
+        const std::string name = getString(eth->second, Dbus::ethName);
+        if (name.empty())
+        {
+            continue;
+        }
+
+        IfaceState& state = ifaces[name];
+        state.mac = getString(getProperties(interfaces, Dbus::macInterface),
+                              Dbus::macSet);
+        state.vlan = getNumber(getProperties(interfaces, Dbus::vlanInterface),
+                               Dbus::vlanId);
+        const std::string object = path;
+        for (const auto& it : Dbus::getAddresses(object.c_str(), objects))
+        {
+            state.addresses.emplace(it.address, it.mask);
+        }
+    }
+    return ifaces;
+}
+
+/**
+ * @brief Get description of IP address with mask.
+ *
+ * @param[in] addr IP address
+ * @param[in] mask mask bits
+ *
+ * @return text in format IP/MASK
+ */
+static std::string ipWithMask(const IpAddr& addr, uint8_t mask)
+{
+    return addr.str() + '/' + std::to_string(mask);
+}
+
+/**
+ * @brief Compare IP addresses of the interface.
+ *
+ * @param[in] iface network interface name
+ * @param[in] dbus addresses seen by the network service
+ * @param[in] kernel addresses programmed in the kernel
+ * @param[out] drift found differences
+ */
+static void compareAddresses(const std::string& iface,
+                             const std::map<IpAddr, uint8_t>& dbus,
+                             const std::map<IpAddr, uint8_t>& kernel,
+                             std::vector<Drift>& drift)
+{
+    // Both maps are sorted by address, so they are joined in a single pass
+    auto d = dbus.begin();
+    auto k = kernel.begin();
+    while (d != dbus.end() || k != kernel.end())
+    {
+        if (k == kernel.end() || (d != dbus.end() && d->first < k->first))
+        {
+            drift.push_back({iface, "ip", ipWithMask(d->first, d->second), ""});
+            ++d;
+        }
+        else if (d == dbus.end() || k->first < d->first)
+        {
+            drift.push_back({iface, "ip", "", ipWithMask(k->first, k->second)});
+            ++k;
+        }
+        else
+        {
+            if (d->second != k->second)
+            {
+                drift.push_back({iface, "ip", ipWithMask(d->first, d->second),
+                                 ipWithMask(k->first, k->second)});
+            }
+            ++d;
+            ++k;
+        }
+    }
+}
+
+std::vector<Drift> findDrift(const Dbus::ManagedObject& dbus,
+                             const Dbus::ManagedObject& kernel)
+{
+    const auto dbusIfaces = collect(dbus);
+    const auto kernelIfaces = collect(kernel);
+
+    std::vector<Drift> drift;
+
+    auto d = dbusIfaces.begin();
+    auto k = kernelIfaces.begin();
+    while (d != dbusIfaces.end() || k != kernelIfaces.end())
+    {
+        if (k == kernelIfaces.end() ||
+            (d != dbusIfaces.end() && d->first < k->first))
+        {
+            drift.push_back({d->first, "interface", "present", ""});
+            ++d;
+            continue;
+        }
+        if (d == dbusIfaces.end() || k->first < d->first)
+        {
+            drift.push_back({k->first, "interface", "", "present"});
+            ++k;
+            continue;
+        }
+
+        const std::string& iface = d->first;
+        const IfaceState& ds = d->second;
+        const IfaceState& ks = k->second;
+        if (ds.vlan != ks.vlan)
+        {
+            drift.push_back({iface, "vlan",
+                             ds.vlan ? std::to_string(ds.vlan) : "",
+                             ks.vlan ? std::to_string(ks.vlan) : ""});
+        }
+        // The network service may report MAC in upper case
+        if (!ds.mac.empty() && strcasecmp(ds.mac.c_str(), ks.mac.c_str()))
+        {
+            drift.push_back({iface, "mac", ds.mac, ks.mac});
+        }
+        compareAddresses(iface, ds.addresses, ks.addresses, drift);
+
+        ++d;
+        ++k;
+    }
+
+    return drift;
+}
+
+void printDrift(Dbus& bus)
+{
+    static const Dbus::Interfaces interfaces = {
+        Dbus::ethInterface, Dbus::vlanInterface, Dbus::macInterface,
+        Dbus::ipInterface};
+
+    // The reply handler writes into the local map: if the netlink dump
+    // throws, the call is cancelled instead of completed later
+    Dbus::ManagedObject dbus;
+    Dbus::AsyncScope scope(bus);
+    bus.getManagedObjectsAsync(interfaces, dbus);
+    const Dbus::ManagedObject kernel = getKernelObjects();
+    bus.waitAll();
+
+    const auto drift = findDrift(dbus, kernel);
+
+    Stats::Timer timer(Stats::render);
+    if (drift.empty())
+    {
+        puts("No drift between the network service and the kernel");
+        return;
+    }
+
+    printf("%-16s %-10s %-30s %s\n", "INTERFACE", "FIELD", "NETWORK SERVICE",
+           "KERNEL");
+    for (const auto& it : drift)
+    {
+        printf("%-16s %-10s %-30s %s\n", it.iface.c_str(), it.field,
+               it.dbus.empty() ? "-" : it.dbus.c_str(),
+               it.kernel.empty() ? "-" : it.kernel.c_str());
+    }
+    fflush(stdout);
+
+    std::string err = std::to_string(drift.size());
+    err += drift.size() == 1 ? " difference" : " differences";
+    err += " found";
+    throw std::runtime_error(err);
+}
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct Drift
+ * @brief Single difference between the network service objects and the
+ *        kernel state.
+ */
+struct Drift
+{
+    /** @brief Network interface name. */
+    std::string iface;
+    /** @brief Differing field: interface, vlan, mac or ip. */
+    const char* field;
+    /** @brief Value seen by the network service, empty if absent. */
+    std::string dbus;
+    /** @brief Value programmed in the kernel, empty if absent. */
+    std::string kernel;
+};
+
+/**
+ * @brief Compare network service objects with the kernel state.
+ *        Interfaces are joined by name, IP addresses by address. Only the
+ *        programmed configuration is compared: interface presence, VLAN Id,
+ *        MAC address and IP addresses with their prefixes.
+ *
+ * @param[in] dbus network service objects
+ * @param[in] kernel kernel state, see getKernelObjects()
+ *
+ * @return differences sorted by interface name
+ */
+std::vector<Drift> findDrift(const Dbus::ManagedObject& dbus,
+                             const Dbus::ManagedObject& kernel);
+
+/**
+ * @brief Take a snapshot of both sources and print differences between
+ *        them. The D-Bus request is sent before the netlink dump and its
+ *        reply is read after it, so the sources are read concurrently.
+ *
+ * @param[in] bus D-Bus instance
+ *
+ * @throw std::runtime_error if any difference has been found
+ * @throw std::exception in case of errors
+ */
+void printDrift(Dbus& bus);
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "ipaddr.hpp"
+
+#include <arpa/inet.h>
+
+#include <charconv>
+
+std::optional<IpAddr> IpAddr::parse(const char* text)
+{
+    // IPv6 address always contains a colon, IPv4 never does
+    IpAddr ip;
+    const bool v6 = strchr(text, ':') != nullptr;
+    if (inet_pton(v6 ? AF_INET6 : AF_INET, text, ip.addr.data()) != 1)
+    {
+        return std::nullopt;
+    }
+    ip.ver = static_cast<uint8_t>(v6 ? IpVer::v6 : IpVer::v4);
+    return ip;
+}
+
+/**
+ * @brief Format IPv4 address in dotted-decimal notation.
+ *
+ * @param[in] addr address bytes
+ * @param[out] buf output buffer
+ *
+ * @return pointer past the last written character
+ */
+static char* formatIp4(const uint8_t* addr, char* buf)
+{
+    for (size_t i = 0; i < 4; ++i)
+    {
+        if (i)
+        {
+            *buf++ = '.';
+        }
+        buf = std::to_chars(buf, buf + 3, addr[i]).ptr;
+    }
+    return buf;
+}
+
+char* IpAddr::format(char* buf) const
+{
+    if (version() == IpVer::v4)
+    {
+        return formatIp4(addr.data(), buf);
+    }
+
+    // Rules of glibc inet_ntop(): the first longest run of at least two
+    // zero words is replaced with "::", IPv4-compatible and IPv4-mapped
+    // addresses have the IPv4 part in dotted-decimal notation
+    constexpr size_t wordsNum = 8;
+    uint16_t words[wordsNum];
+    for (size_t i = 0; i < wordsNum; ++i)
+    {
+        words[i] = static_cast<uint16_t>(addr[i * 2] << 8 | addr[i * 2 + 1]);
+    }
+
+    size_t bestBase = wordsNum, bestLen = 0;
+    for (size_t i = 0; i < wordsNum;)
+    {
+        if (words[i])
+        {
+            ++i;
+            continue;
+        }
+        size_t len = 0;
+        while (i + len < wordsNum && !words[i + len])
+        {
+            ++len;
+        }
+        if (len > bestLen)
+        {
+            bestBase = i;
+            bestLen = len;
+        }
+        i += len;
+    }
+    if (bestLen < 2)
+    {
+        bestBase = wordsNum;
+        bestLen = 0;
+    }
+
+    for (size_t i = 0; i < wordsNum; ++i)
+    {
+        if (i >= bestBase && i < bestBase + bestLen)
+        {
+            if (i == bestBase)
+            {
+                *buf++ = ':';
+            }
+            continue;
+        }
+        if (i)
+        {
+            *buf++ = ':';
+        }
+        if (i == 6 && bestBase == 0 &&
+            (bestLen == 6 || (bestLen == 5 && words[5] == 0xffff)))
+        {
+            return formatIp4(addr.data() + 12, buf);
+        }
+        buf = std::to_chars(buf, buf + 4, words[i], 16).ptr;
+    }
+    if (bestLen && bestBase + bestLen == wordsNum)
+    {
+        *buf++ = ':';
+    }
+
+    return buf;
+}
+
+std::string IpAddr::str() const
+{
+    char buf[maxTextLen];
+    return std::string(buf, format(buf));
+}
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+
+/**
+ * @class IpVer
+ * @brief IP version.
+ */
+enum class IpVer
+{
+    v4 = 4,
+    v6 = 6
+};
+
+/**
+ * @class IpAddr
+ * @brief IP address in binary form: version and 16 bytes of address
+ *        (IPv4 address occupies the first 4 bytes, the rest are zero).
+ */
+class IpAddr
+{
+  public:
+    /** @brief Max length of the text representation (without null). */
+    static constexpr size_t maxTextLen = 45;
+
+    /** @brief Constructor: unspecified IPv4 address (0.0.0.0). */
+    IpAddr() : ver(static_cast<uint8_t>(IpVer::v4)), addr{}
+    {}
+
+    /**
+     * @brief Parse text representation of the IP address.
+     *
+     * @param[in] text IPv4 address in dotted-decimal format or IPv6 address
+     *
+     * @return IP address or std::nullopt if text is not a valid address
+     */
+    static std::optional<IpAddr> parse(const char* text);
+
+    /**
+     * @brief Get IP version.
+     *
+     * @return IP version
+     */
+    IpVer version() const
+    {
+        return static_cast<IpVer>(ver);
+    }
+
+    /**
+     * @brief Get address bytes in network order.
+     *
+     * @return pointer to address bytes, 4 bytes for IPv4 and 16 for IPv6
+     */
+    const uint8_t* data() const
+    {
+        return addr.data();
+    }
+
+    /**
+     * @brief Format address in the same way as inet_ntop() does.
+     *
+     * @param[out] buf output buffer, must be at least maxTextLen bytes
+     *
+     * @return pointer past the last written character
+     */
+    char* format(char* buf) const;
+
+    /**
+     * @brief Get text representation of the address.
+     *
+     * @return text representation of the address
+     */
+    std::string str() const;
+
+    bool operator==(const IpAddr& other) const
+    {
+        return ver == other.ver &&
+               memcmp(addr.data(), other.addr.data(), addr.size()) == 0;
+    }
+    bool operator!=(const IpAddr& other) const
+    {
+        return !(*this == other);
+    }
+    bool operator<(const IpAddr& other) const
+    {
+        return ver != other.ver
+                   ? ver < other.ver
+                   : memcmp(addr.data(), other.addr.data(), addr.size()) < 0;
+    }
+
+  private:
+    /** @brief IP version. */
+    uint8_t ver;
+    /** @brief Address bytes in network order. */
+    std::array<uint8_t, 16> addr;
+};
+
+static_assert(sizeof(IpAddr) == 17);
+
+namespace std
+{
+template <>
+struct hash<IpAddr>
+{
+    size_t operator()(const IpAddr& ip) const
+    {
+        uint64_t hi, lo;
+        memcpy(&hi, ip.data(), sizeof(hi));
+        memcpy(&lo, ip.data() + sizeof(hi), sizeof(lo));
+        return std::hash<uint64_t>()(hi ^ (lo * 0x9e3779b97f4a7c15ull) ^
+                                     static_cast<uint64_t>(ip.version()));
+    }
+};
+} // namespace std
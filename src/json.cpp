@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "json.hpp"
+
+#include <charconv>
+
+JsonWriter::JsonWriter(FILE* out) : out(out), afterKey(false)
+{}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separator();
+    fputc('{', out);
+    empty.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    fputc('}', out);
+    empty.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separator();
+    fputc('[', out);
+    empty.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    fputc(']', out);
+    empty.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name)
+{
+    string(name);
+    fputc(':', out);
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::string(std::string_view str)
+{
+    separator();
+    fputc('"', out);
+
+    // Characters that don't need escaping are written in runs
+    size_t start = 0;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        fwrite(str.data() + start, 1, i - start, out);
+        start = i + 1;
+        switch (c)
+        {
+            case '"':
+                fputs("\\\"", out);
+                break;
+            case '\\':
+                fputs("\\\\", out);
+                break;
+            case '\n':
+                fputs("\\n", out);
+                break;
+            case '\r':
+                fputs("\\r", out);
+                break;
+            case '\t':
+                fputs("\\t", out);
+                break;
+            default:
+                fprintf(out, "\\u%04x", c);
+                break;
+        }
+    }
+    fwrite(str.data() + start, 1, str.size() - start, out);
+
+    fputc('"', out);
+    return *this;
+}
+
+JsonWriter& JsonWriter::number(uint64_t num)
+{
+    separator();
+    char buf[20];
+    const char* end = std::to_chars(buf, buf + sizeof(buf), num).ptr;
+    fwrite(buf, 1, end - buf, out);
+    return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool val)
+{
+    separator();
+    fputs(val ? "true" : "false", out);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separator();
+    fputs("null", out);
+    return *this;
+}
+
+JsonWriter& JsonWriter::strings(const std::vector<std::string>& list)
+{
+    beginArray();
+    for (const auto& it : list)
+    {
+        string(it);
+    }
+    return endArray();
+}
+
+void JsonWriter::endLine()
+{
+    fputc('\n', out);
+}
+
+void JsonWriter::separator()
+{
+    if (afterKey)
+    {
+        // Member value follows its name without a comma
+        afterKey = false;
+        return;
+    }
+    if (!empty.empty())
+    {
+        if (!empty.back())
+        {
+            fputc(',', out);
+        }
+        empty.back() = false;
+    }
+}
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class JsonWriter
+ * @brief Streaming JSON writer.
+ *
+ * Values are written straight to the output stream as they come, commas
+ * and colons are inserted automatically. Nothing is buffered besides the
+ * stream itself, so the document is never built in memory.
+ */
+class JsonWriter
+{
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] out output stream
+     */
+    explicit JsonWriter(FILE* out = stdout);
+
+    /** @brief Start object: `{`. */
+    JsonWriter& beginObject();
+
+    /** @brief End object: `}`. */
+    JsonWriter& endObject();
+
+    /** @brief Start array: `[`. */
+    JsonWriter& beginArray();
+
+    /** @brief End array: `]`. */
+    JsonWriter& endArray();
+
+    /**
+     * @brief Write object member name, the value must follow.
+     *
+     * @param[in] name member name
+     */
+    JsonWriter& key(std::string_view name);
+
+    /**
+     * @brief Write string value.
+     *
+     * @param[in] str string to write, escaped as needed
+     */
+    JsonWriter& string(std::string_view str);
+
+    /**
+     * @brief Write numeric value.
+     *
+     * @param[in] num number to write
+     */
+    JsonWriter& number(uint64_t num);
+
+    /**
+     * @brief Write boolean value.
+     *
+     * @param[in] val value to write
+     */
+    JsonWriter& boolean(bool val);
+
+    /** @brief Write `null`. */
+    JsonWriter& null();
+
+    /**
+     * @brief Write array of strings.
+     *
+     * @param[in] list strings to write
+     */
+    JsonWriter& strings(const std::vector<std::string>& list);
+
+    /**
+     * @brief Finish the top-level value with a newline, so every value is
+     *        a separate JSON Lines record.
+     */
+    void endLine();
+
+  private:
+    /** @brief Write separator before the next value if needed. */
+    void separator();
+
+    /** @brief Output stream. */
+    FILE* out;
+    /** @brief Nesting stack, true while the container is empty. */
+    std::vector<bool> empty;
+    /** @brief Flag: member name has been written, its value is expected. */
+    bool afterKey;
+};
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "kernel.hpp"
+
+#include "netifaces.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/if_arp.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * @brief Read link speed from sysfs.
+ *
+ * @param[in] name network interface name
+ *
+ * @return speed in Mbps, 0 if unknown (link is down)
+ */
+static uint32_t readSpeed(const std::string& name)
+{
+    const std::string path = "/sys/class/net/" + name + "/speed";
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return 0;
+    }
+    char buf[16];
+    const ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+    {
+        return 0;
+    }
+    buf[len] = 0;
+    const long speed = strtol(buf, nullptr, 10);
+    return speed > 0 ? static_cast<uint32_t>(speed) : 0;
+}
+
+/**
+ * @brief Format MAC address.
+ *
+ * @param[in] data address bytes
+ * @param[in] size number of bytes
+ *
+ * @return text in format xx:xx:xx:xx:xx:xx
+ */
+static std::string formatMac(const uint8_t* data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string mac;
+    mac.reserve(size * 3);
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (i)
+        {
+            mac += ':';
+        }
+        mac += digits[data[i] >> 4];
+        mac += digits[data[i] & 0xf];
+    }
+    return mac;
+}
+
+/**
+ * @brief Get VLAN Id from the link info attribute.
+ *
+ * @param[in] linkInfo IFLA_LINKINFO attribute
+ *
+ * @return VLAN Id, 0 if the link is not a VLAN
+ */
+static uint32_t getVlanId(const rtattr* linkInfo)
+{
+    bool vlan = false;
+    const rtattr* data = nullptr;
+    size_t len = RTA_PAYLOAD(linkInfo);
+    for (const rtattr* rta = static_cast<const rtattr*>(RTA_DATA(linkInfo));
+         RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if (rta->rta_type == IFLA_INFO_KIND)
+        {
+            vlan = !strcmp(static_cast<const char*>(RTA_DATA(rta)), "vlan");
+        }
+        else if (rta->rta_type == IFLA_INFO_DATA)
+        {
+            data = rta;
+        }
+    }
+    if (!vlan || !data)
+    {
+        return 0;
+    }
+
+    len = RTA_PAYLOAD(data);
+    for (const rtattr* rta = static_cast<const rtattr*>(RTA_DATA(data));
+         RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if (rta->rta_type == IFLA_VLAN_ID)
+        {
+            return *static_cast<const uint16_t*>(RTA_DATA(rta));
+        }
+    }
+    return 0;
+}
+
+Dbus::ManagedObject getKernelObjects()
+{
+    Dbus::ManagedObject objects;
+
+    char hostname[HOST_NAME_MAX + 1];
+    if (gethostname(hostname, sizeof(hostname)) == 0)
+    {
+        hostname[HOST_NAME_MAX] = 0;
+        objects[Dbus::objectConfig][Dbus::syscfgInterface]
+               [Dbus::syscfgHostname] = std::string(hostname);
+    }
+
+    RtNetlink netlink;
+
+    // Interface index to its object path, addresses refer to the index
+    std::unordered_map<int, std::string> links;
+    bool ok = netlink.dump(RTM_GETLINK, [&](const nlmsghdr* hdr) {
+        if (hdr->nlmsg_type != RTM_NEWLINK)
+        {
+            return;
+        }
+        const auto* ifi = static_cast<const ifinfomsg*>(NLMSG_DATA(hdr));
+        if (ifi->ifi_type != ARPHRD_ETHER)
+        {
+            return;
+        }
+
+        const char* name = nullptr;
+        const rtattr* mac = nullptr;
+        uint32_t vlanId = 0;
+        size_t attrLen = IFLA_PAYLOAD(hdr);
+        for (const rtattr* rta = IFLA_RTA(ifi); RTA_OK(rta, attrLen);
+             rta = RTA_NEXT(rta, attrLen))
+        {
+            switch (rta->rta_type)
+            {
+                case IFLA_IFNAME:
+                    name = static_cast<const char*>(RTA_DATA(rta));
+                    break;
+                case IFLA_ADDRESS:
+                    mac = rta;
+                    break;
+                case IFLA_LINKINFO:
+                    vlanId = getVlanId(rta);
+                    break;
+            }
+        }
+        if (!name)
+        {
+            return;
+        }
+
+        const std::string path = Dbus::ethToPath(name);
+        auto& object = objects[path];
+        auto& eth = object[Dbus::ethInterface];
+        eth[Dbus::ethName] = std::string(name);
+        // The network service reports IFF_RUNNING as the link state
+        eth[Dbus::ethLinkUp] = (ifi->ifi_flags & IFF_RUNNING) != 0;
+        if (const uint32_t speed = readSpeed(name))
+        {
+            eth[Dbus::ethSpeed] = speed;
+        }
+        if (mac)
+        {
+            object[Dbus::macInterface][Dbus::macSet] =
+                formatMac(static_cast<const uint8_t*>(RTA_DATA(mac)),
+                          RTA_PAYLOAD(mac));
+        }
+        if (vlanId)
+        {
+            object[Dbus::vlanInterface][Dbus::vlanId] = vlanId;
+        }
+        links.emplace(ifi->ifi_index, path);
+    });
+
+    size_t addrCount = 0;
+    ok = ok && netlink.dump(RTM_GETADDR, [&](const nlmsghdr* hdr) {
+        if (hdr->nlmsg_type != RTM_NEWADDR)
+        {
+            return;
+        }
+        const auto* ifa = static_cast<const ifaddrmsg*>(NLMSG_DATA(hdr));
+        const auto link = links.find(static_cast<int>(ifa->ifa_index));
+        if (link == links.end() ||
+            (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6))
+        {
+            return;
+        }
+
+        // IFA_LOCAL is the address itself for point-to-point links
+        const void* addr = nullptr;
+        uint32_t flags = ifa->ifa_flags;
+        size_t attrLen = IFA_PAYLOAD(hdr);
+        for (const rtattr* rta = IFA_RTA(ifa); RTA_OK(rta, attrLen);
+             rta = RTA_NEXT(rta, attrLen))
+        {
+            if (rta->rta_type == IFA_LOCAL ||
+                (rta->rta_type == IFA_ADDRESS && !addr))
+            {
+                addr = RTA_DATA(rta);
+            }
+            else if (rta->rta_type == IFA_FLAGS)
+            {
+                flags = *static_cast<const uint32_t*>(RTA_DATA(rta));
+            }
+        }
+        if (!addr)
+        {
+            return;
+        }
+
+        char text[INET6_ADDRSTRLEN];
+        inet_ntop(ifa->ifa_family, addr, text, sizeof(text));
+
+        const char* origin = Dbus::ipOriginDhcp;
+        if (ifa->ifa_scope == RT_SCOPE_LINK)
+        {
+            origin = Dbus::ipOriginLinkLocal;
+        }
+        else if (flags & IFA_F_PERMANENT)
+        {
+            origin = Dbus::ipOriginStatic;
+        }
+
+        // Fixed width keeps the addresses in the order of the dump
+        char id[32];
+        snprintf(id, sizeof(id), "/%s/%04zx",
+                 ifa->ifa_family == AF_INET ? "ipv4" : "ipv6", addrCount++);
+
+        auto& ip = objects[link->second + id][Dbus::ipInterface];
+        ip[Dbus::ipAddress] = std::string(text);
+        ip[Dbus::ipPrefix] = ifa->ifa_prefixlen;
+        ip[Dbus::ipGateway] = std::string();
+        ip[Dbus::ipOrigin] = std::string(origin);
+    });
+
+    if (!ok)
+    {
+        throw std::runtime_error("Unable to read network state from kernel");
+    }
+
+    return objects;
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+
+/**
+ * @brief Read network interfaces state directly from the kernel: a single
+ *        RTM_GETLINK and a single RTM_GETADDR netlink dump, link speed is
+ *        read from sysfs. D-Bus is not used, so the result doesn't depend
+ *        on the network service health.
+ *
+ * The state is returned in the same form as the network service objects,
+ * so it can be rendered in the same way. Only Ethernet interfaces are
+ * included. Configuration known only to the network service (DHCP, DNS,
+ * NTP, gateways) is absent; dynamic addresses are reported as DHCP ones.
+ *
+ * @throw std::runtime_error if netlink request failed
+ *
+ * @return network objects
+ */
+Dbus::ManagedObject getKernelObjects();
@@ -1,11 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (C) 2020-2021 YADRO
 
+#include "apply.hpp"
+#include "batch.hpp"
+#include "client.hpp"
 #include "netconfig.hpp"
+#include "shell.hpp"
+#include "stats.hpp"
 #include "version.hpp"
 
-#include <sdbusplus/exception.hpp>
-
 #include <cstring>
 
 bool isHelp(const char* str)
@@ -31,6 +34,15 @@ void printNetconfigHelp()
     printf("COMMANDS:\n");
     printf("  ifconfig\tNetwork configuration commands\n");
     printf("  syslog\tRemote syslog server commands\n");
+    printf("  batch\t\tExecute commands from FILE or stdin, one per line\n");
+    printf("  \t\tCommand format: batch [FILE|-]\n");
+    printf("  apply\t\tBring configuration to the state described in FILE\n");
+    printf("  \t\tCommand format: apply [--dry-run] FILE\n");
+    printf("  shell\t\tInteractive shell, commands share the connection\n");
+    printf("  \t\tand the cached state of the network service\n\n");
+    printf("OPTIONS:\n");
+    printf("  --stats\tPrint execution time statistics to stderr\n");
+    printf("  --trace\tPrint statistics and every D-Bus call to stderr\n");
 }
 
 CLIMode setMode(const char* cmd)
@@ -50,7 +62,9 @@ CLIMode setMode(const char* cmd)
 
 bool parseNetconfigCmd(const char* cmd)
 {
-    if (cmd && (!strcmp(cmd, ifcfg) || !strcmp(cmd, sslg)))
+    if (cmd && (!strcmp(cmd, ifcfg) || !strcmp(cmd, sslg) ||
+                !strcmp(cmd, btch) || !strcmp(cmd, aply) ||
+                !strcmp(cmd, shll)))
     {
         return true;
     }
@@ -65,12 +79,16 @@ bool parseNetconfigCmd(const char* cmd)
     }
 }
 
-/** @brief Application entry point. */
-int main(int argc, char* argv[])
+/**
+ * @brief Run the command.
+ *
+ * @param[in] app  application name
+ * @param[in] args command line arguments
+ *
+ * @return exit code
+ */
+static int run(const char* app, Arguments& args)
 {
-    Arguments args(argc, argv);
-    const char* app = args.asText();
-
     try
     {
         const char* cmd = args.peek();
@@ -87,6 +105,52 @@ int main(int argc, char* argv[])
             {
                 return EXIT_SUCCESS;
             }
+
+            if (!strcmp(cmd, btch))
+            {
+                ++args;
+                if (isHelp(args.peek()))
+                {
+                    printNetconfigHelp();
+                    return EXIT_SUCCESS;
+                }
+                const char* file = args.peek() ? args.asText() : "-";
+                args.expectEnd();
+                return batch(file) ? EXIT_FAILURE : EXIT_SUCCESS;
+            }
+
+            if (!strcmp(cmd, shll))
+            {
+                ++args;
+                if (isHelp(args.peek()))
+                {
+                    printNetconfigHelp();
+                    return EXIT_SUCCESS;
+                }
+                args.expectEnd();
+                shell();
+                return EXIT_SUCCESS;
+            }
+
+            if (!strcmp(cmd, aply))
+            {
+                ++args;
+                if (!args.peek() || isHelp(args.peek()))
+                {
+                    printNetconfigHelp();
+                    return EXIT_SUCCESS;
+                }
+                const bool dryRun = !strcmp(args.peek(), "--dry-run");
+                if (dryRun)
+                {
+                    ++args;
+                }
+                Apply desired(args.asText());
+                args.expectEnd();
+                Dbus bus;
+                desired.run(bus, dryRun);
+                return EXIT_SUCCESS;
+            }
         }
 
         ++args;
@@ -115,27 +179,39 @@ int main(int argc, char* argv[])
         }
         else
         {
+            // Statistics are collected only for commands executed directly
+            int status;
+            if (!Stats::enabled() && !isLongRunning(args) &&
+                !isOffline(args) && !isSnapshotRead(app_str.c_str(), args) &&
+                executeRemote(app_str.c_str(), args, status))
+            {
+                return status;
+            }
             execute(app_str.c_str(), args);
         }
     }
-    catch (sdbusplus::exception::SdBusError& ex)
-    {
-        std::string what = ex.what();
-        if (what.find("UnreachableGW") != std::string::npos)
-            fprintf(stderr, "Unreachable gateway specified\n");
-        else if (what.find("NotAllowed") != std::string::npos)
-            fprintf(stderr, "The operation is not allowed because no static "
-                            "addresses found\n");
-        else
-            fprintf(stderr, "%s\n", ex.what());
-
-        return EXIT_FAILURE;
-    }
     catch (std::exception& ex)
     {
-        fprintf(stderr, "%s\n", ex.what());
+        printError(ex);
         return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
 }
+
+/** @brief Application entry point. */
+int main(int argc, char* argv[])
+{
+    Arguments args(argc, argv);
+    const char* app = args.asText();
+
+    const bool trace = args.takeOption("--trace").has_value();
+    if (args.takeOption("--stats") || trace)
+    {
+        Stats::enable(trace);
+    }
+    const int rc = run(app, args);
+    Stats::report();
+
+    return rc;
+}
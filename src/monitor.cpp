@@ -0,0 +1,463 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "monitor.hpp"
+
+#include "show.hpp"
+
+#include <cinttypes>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @struct Monitor::Field
+ * @brief Description of the monitored field.
+ */
+struct Monitor::Field
+{
+    /** @brief Field name, the same as `get` command selector. */
+    const char* name;
+    /** @brief D-Bus interface name. */
+    const char* interface;
+    /** @brief D-Bus property name, nullptr for IP address. */
+    const char* property;
+};
+
+// clang-format off
+/** @brief Global network configuration fields. */
+static const Monitor::Field globalFields[] = {
+    {"hostname", Dbus::syscfgInterface, Dbus::syscfgHostname},
+    {"gateway", Dbus::syscfgInterface, Dbus::syscfgDefGw4},
+    {"gateway6", Dbus::syscfgInterface, Dbus::syscfgDefGw6},
+};
+
+/** @brief Global DHCP configuration fields. */
+static const Monitor::Field dhcpFields[] = {
+    {"dhcp-dns", Dbus::dhcpInterface, Dbus::dhcpDnsEnabled},
+    {"dhcp-ntp", Dbus::dhcpInterface, Dbus::dhcpNtpEnabled},
+};
+
+/** @brief Network interface fields. */
+static const Monitor::Field ifaceFields[] = {
+    {"mac", Dbus::macInterface, Dbus::macSet},
+    {"link", Dbus::ethInterface, Dbus::ethLinkUp},
+    {"speed", Dbus::ethInterface, Dbus::ethSpeed},
+    {"dhcp", Dbus::ethInterface, Dbus::ethDhcpEnabled},
+    {"dns", Dbus::ethInterface, Dbus::ethNameServers},
+    {"dns.static", Dbus::ethInterface, Dbus::ethStNameServers},
+    {"ntp", Dbus::ethInterface, Dbus::ethNtpServers},
+};
+
+/** @brief IP address object field. */
+static const Monitor::Field ipFields[] = {
+    {"ip", Dbus::ipInterface, nullptr},
+};
+// clang-format on
+
+/** @brief Name of the pseudo interface for global configuration events. */
+static constexpr const char* globalName = "global";
+
+/** @brief Size of the output buffer, events are flushed once per batch. */
+static constexpr size_t outputBufferSize = 64 * 1024;
+
+Monitor::Monitor(Dbus& bus, bool json) : bus(bus)
+{
+    if (json)
+    {
+        this->json.emplace(stdout);
+    }
+
+    bus.observeCache([this](const std::string& path) {
+        if (path.empty())
+        {
+            updateAll();
+        }
+        else
+        {
+            update(path);
+        }
+    });
+
+    // Initial state is not reported
+    for (const auto& [path, interfaces] : bus.cachedObjects())
+    {
+        auto entry = snapshot(path, interfaces);
+        if (entry)
+        {
+            ++activity[entry->iface].objects;
+            objects.emplace(path, std::move(*entry));
+        }
+    }
+}
+
+void Monitor::run()
+{
+    // Bursts of signals are written with a few large writes instead of a
+    // write per line, so the output never falls behind the bus
+    setvbuf(stdout, nullptr, _IOFBF, outputBufferSize);
+
+    while (true)
+    {
+        bus.wait(std::numeric_limits<uint64_t>::max());
+        if (fflush(stdout) != 0)
+        {
+            throw std::runtime_error("Unable to write events");
+        }
+    }
+}
+
+void Monitor::update(const std::string& path)
+{
+    const auto& tree = bus.cachedObjects();
+    const auto object = tree.find(path);
+    std::optional<Entry> current;
+    if (object != tree.end())
+    {
+        current = snapshot(path, object->second);
+    }
+
+    auto prev = objects.find(path);
+    if (prev == objects.end())
+    {
+        if (!current)
+        {
+            return;
+        }
+        prev = objects.emplace(path, std::move(*current)).first;
+        const Entry& entry = prev->second;
+        ++activity[entry.iface].objects;
+        if (entry.fields == ifaceFields)
+        {
+            report(entry.iface, "interface", std::nullopt, entry.iface);
+        }
+        else if (entry.fields == ipFields)
+        {
+            report(entry.iface, entry.fields->name, std::nullopt,
+                   entry.values.front());
+        }
+        else
+        {
+            // Global objects reappear after the network service restart
+            for (size_t i = 0; i < entry.values.size(); ++i)
+            {
+                if (entry.values[i])
+                {
+                    report(entry.iface, entry.fields[i].name, std::nullopt,
+                           entry.values[i]);
+                }
+            }
+        }
+        return;
+    }
+
+    Entry& entry = prev->second;
+    if (!current)
+    {
+        if (entry.fields == ifaceFields)
+        {
+            report(entry.iface, "interface", entry.iface, std::nullopt);
+        }
+        else if (entry.fields == ipFields)
+        {
+            report(entry.iface, entry.fields->name, entry.values.front(),
+                   std::nullopt);
+        }
+        else
+        {
+            for (size_t i = 0; i < entry.values.size(); ++i)
+            {
+                if (entry.values[i])
+                {
+                    report(entry.iface, entry.fields[i].name,
+                           entry.values[i], std::nullopt);
+                }
+            }
+        }
+        const auto it = activity.find(entry.iface);
+        if (it != activity.end() && --it->second.objects == 0)
+        {
+            activity.erase(it);
+        }
+        objects.erase(prev);
+        return;
+    }
+
+    for (size_t i = 0; i < entry.values.size(); ++i)
+    {
+        if (entry.values[i] != current->values[i])
+        {
+            report(entry.iface, entry.fields[i].name, entry.values[i],
+                   current->values[i]);
+        }
+    }
+    entry.values.swap(current->values);
+}
+
+void Monitor::updateAll()
+{
+    std::vector<std::string> paths;
+    paths.reserve(objects.size());
+    for (const auto& it : objects)
+    {
+        paths.push_back(it.first);
+    }
+    for (const auto& it : bus.cachedObjects())
+    {
+        if (objects.find(it.first) == objects.end())
+        {
+            paths.push_back(it.first);
+        }
+    }
+
+    for (const auto& path : paths)
+    {
+        update(path);
+    }
+}
+
+/**
+ * @brief Get property value.
+ *
+ * @param[in] interfaces object interfaces with their properties
+ * @param[in] interface interface name
+ * @param[in] property property name
+ *
+ * @return property value or nothing if not found
+ */
+static std::optional<Dbus::PropertyValue>
+    getValue(const std::map<std::string, Dbus::Properties>& interfaces,
+             const char* interface, const char* property)
+{
+    const auto iface = interfaces.find(interface);
+    if (iface != interfaces.end())
+    {
+        const auto value = iface->second.find(property);
+        if (value != iface->second.end())
+        {
+            return value->second;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Monitor::Entry> Monitor::snapshot(
+    const std::string& path,
+    const std::map<std::string, Dbus::Properties>& interfaces) const
+{
+    Entry entry;
+
+    const size_t rootLen = strlen(Dbus::objectRoot);
+    if (path == Dbus::objectConfig)
+    {
+        entry.iface = globalName;
+        entry.fields = globalFields;
+        entry.values.resize(std::size(globalFields));
+    }
+    else if (path == Dbus::objectDhcp)
+    {
+        entry.iface = globalName;
+        entry.fields = dhcpFields;
+        entry.values.resize(std::size(dhcpFields));
+    }
+    else if (path.size() > rootLen + 1 &&
+             path.compare(0, rootLen, Dbus::objectRoot) == 0 &&
+             path[rootLen] == '/')
+    {
+        // Network interface is a direct child of the root, its addresses
+        // are placed below it
+        const size_t sep = path.find('/', rootLen + 1);
+        if (sep == std::string::npos)
+        {
+            if (interfaces.find(Dbus::ethInterface) == interfaces.end())
+            {
+                return std::nullopt;
+            }
+            const auto name =
+                getValue(interfaces, Dbus::ethInterface, Dbus::ethName);
+            const std::string* str =
+                name ? std::get_if<std::string>(&*name) : nullptr;
+            entry.iface =
+                str && !str->empty() ? *str : path.substr(rootLen + 1);
+            entry.fields = ifaceFields;
+            entry.values.resize(std::size(ifaceFields));
+        }
+        else
+        {
+            const auto ip = interfaces.find(Dbus::ipInterface);
+            if (ip == interfaces.end())
+            {
+                return std::nullopt;
+            }
+            const auto parent = objects.find(path.substr(0, sep));
+            entry.iface = parent != objects.end()
+                              ? parent->second.iface
+                              : path.substr(rootLen + 1, sep - rootLen - 1);
+            entry.fields = ipFields;
+
+            // Address is reported as a single value: ADDR/MASK (ORIGIN)
+            std::string text;
+            const auto& props = ip->second;
+            const auto addr = props.find(Dbus::ipAddress);
+            if (addr != props.end())
+            {
+                if (const auto* str = std::get_if<std::string>(&addr->second))
+                {
+                    text = *str;
+                }
+            }
+            const auto prefix = props.find(Dbus::ipPrefix);
+            if (prefix != props.end())
+            {
+                if (const auto* mask = std::get_if<uint8_t>(&prefix->second))
+                {
+                    text += '/';
+                    text += std::to_string(*mask);
+                }
+            }
+            const auto origin = props.find(Dbus::ipOrigin);
+            if (origin != props.end())
+            {
+                const auto* str = std::get_if<std::string>(&origin->second);
+                if (str && *str != Dbus::ipOriginStatic)
+                {
+                    text += " (";
+                    text += Dbus::shortEnum(*str);
+                    text += ')';
+                }
+            }
+            entry.values.emplace_back(std::move(text));
+            return entry;
+        }
+    }
+    else
+    {
+        return std::nullopt;
+    }
+
+    for (size_t i = 0; i < entry.values.size(); ++i)
+    {
+        entry.values[i] = getValue(interfaces, entry.fields[i].interface,
+                                   entry.fields[i].property);
+    }
+    return entry;
+}
+
+/**
+ * @brief Print value as text.
+ *
+ * @param[in] value value to print, nothing if absent
+ */
+static void printValue(const std::optional<Dbus::PropertyValue>& value)
+{
+    static const char* none = "(none)";
+    if (!value)
+    {
+        fputs(none, stdout);
+        return;
+    }
+
+    std::visit(
+        [](auto&& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                fputs(arg ? "true" : "false", stdout);
+            }
+            else if constexpr (std::is_arithmetic<T>::value)
+            {
+                printf("%u", static_cast<unsigned int>(arg));
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                fputs(arg.empty() ? none : Dbus::shortEnum(arg), stdout);
+            }
+            else if constexpr (std::is_same_v<T, std::vector<std::string>>)
+            {
+                if (arg.empty())
+                {
+                    fputs(none, stdout);
+                }
+                for (size_t i = 0; i < arg.size(); ++i)
+                {
+                    if (i)
+                    {
+                        fputs(", ", stdout);
+                    }
+                    fputs(arg[i].c_str(), stdout);
+                }
+            }
+            else
+            {
+                static_assert(T::value, "Unhandled value type");
+            }
+        },
+        *value);
+}
+
+void Monitor::report(const std::string& iface, const char* field,
+                     const Value& oldVal, const Value& newVal)
+{
+    using namespace std::chrono;
+
+    // Steady clock is CLOCK_MONOTONIC: time since boot, never adjusted
+    const auto now = steady_clock::now();
+    const uint64_t time =
+        duration_cast<microseconds>(now.time_since_epoch()).count();
+    std::optional<uint64_t> delta;
+    auto& last = activity[iface].lastEvent;
+    if (last)
+    {
+        delta = duration_cast<microseconds>(now - *last).count();
+    }
+    last = now;
+
+    if (json)
+    {
+        json->beginObject();
+        json->key("time").number(time);
+        json->key("delta");
+        if (delta)
+        {
+            json->number(*delta);
+        }
+        else
+        {
+            json->null();
+        }
+        json->key("interface").string(iface);
+        json->key("field").string(field);
+        json->key("old");
+        if (oldVal)
+        {
+            Show::writeValue(*json, *oldVal);
+        }
+        else
+        {
+            json->null();
+        }
+        json->key("new");
+        if (newVal)
+        {
+            Show::writeValue(*json, *newVal);
+        }
+        else
+        {
+            json->null();
+        }
+        json->endObject().endLine();
+        return;
+    }
+
+    printf("[%6" PRIu64 ".%06u] %s %s: ", time / 1000000,
+           static_cast<unsigned int>(time % 1000000), iface.c_str(), field);
+    printValue(oldVal);
+    fputs(" -> ", stdout);
+    printValue(newVal);
+    if (delta)
+    {
+        printf(" (+%" PRIu64 ".%06u)", *delta / 1000000,
+               static_cast<unsigned int>(*delta % 1000000));
+    }
+    putchar('\n');
+}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+#include "json.hpp"
+
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+
+/**
+ * @class Monitor
+ * @brief Prints network configuration changes as a stream of events.
+ *
+ * The objects tree is mirrored by the objects cache, every signal from the
+ * network service is compared with the previous state of the changed
+ * object only, and each changed value is printed as a separate line.
+ * The state is proportional to the number of network objects, events are
+ * never queued: they are written to the output buffer as soon as the
+ * signal is handled.
+ */
+class Monitor
+{
+  public:
+    struct Field;
+
+    /**
+     * @brief Constructor: subscribes to changes and saves the initial state.
+     *
+     * @param[in] bus D-Bus instance
+     * @param[in] json print events as JSON Lines records
+     *
+     * @throw std::exception in case of errors
+     */
+    Monitor(Dbus& bus, bool json);
+
+    /**
+     * @brief Print events until interrupted. Never returns.
+     *
+     * @throw std::exception in case of errors
+     */
+    void run();
+
+  private:
+    /** @brief Optional property value, empty if the property is absent. */
+    using Value = std::optional<Dbus::PropertyValue>;
+
+    /**
+     * @struct Entry
+     * @brief Monitored state of a single D-Bus object.
+     */
+    struct Entry
+    {
+        /** @brief Network interface name, `global` for global objects. */
+        std::string iface;
+        /** @brief Monitored fields. */
+        const Field* fields;
+        /** @brief Field values, same order as the fields. */
+        std::vector<Value> values;
+    };
+
+    /**
+     * @brief Handle change of the object.
+     *
+     * @param[in] path path to the changed object
+     */
+    void update(const std::string& path);
+
+    /** @brief Handle reload of the whole tree: compare every object. */
+    void updateAll();
+
+    /**
+     * @brief Get monitored state of the object.
+     *
+     * @param[in] path path to the object
+     * @param[in] interfaces object interfaces with their properties
+     *
+     * @return state or nothing if the object is not monitored
+     */
+    std::optional<Entry>
+        snapshot(const std::string& path,
+                 const std::map<std::string, Dbus::Properties>& interfaces)
+            const;
+
+    /**
+     * @brief Print event.
+     *
+     * @param[in] iface network interface name
+     * @param[in] field field name
+     * @param[in] oldVal previous value
+     * @param[in] newVal current value
+     */
+    void report(const std::string& iface, const char* field,
+                const Value& oldVal, const Value& newVal);
+
+  private:
+    /** @brief D-Bus connection. */
+    Dbus& bus;
+    /** @brief JSON writer, nothing if text output is used. */
+    std::optional<JsonWriter> json;
+    /** @brief Monitored objects state by their paths. */
+    std::unordered_map<std::string, Entry> objects;
+    /**
+     * @struct Activity
+     * @brief Events timing of a single network interface.
+     */
+    struct Activity
+    {
+        /** @brief Number of monitored objects of the interface. */
+        size_t objects = 0;
+        /** @brief Time of the last event, nothing before the first one. */
+        std::optional<std::chrono::steady_clock::time_point> lastEvent;
+    };
+
+    /** @brief Events timing by network interface name, kept while the
+     *         interface has any monitored objects (e.g. IP addresses are
+     *         removed after the interface object). */
+    std::unordered_map<std::string, Activity> activity;
+};
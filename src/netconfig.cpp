@@ -4,9 +4,22 @@
 #include "netconfig.hpp"
 
 #include "dbus.hpp"
+#include "drift.hpp"
+#include "json.hpp"
+#include "kernel.hpp"
+#include "monitor.hpp"
+#include "networkd.hpp"
+#include "query.hpp"
 #include "show.hpp"
+#include "waiter.hpp"
 
+#include <sdbusplus/exception.hpp>
+
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 
 /**
  * @brief Command handler function.
@@ -32,16 +45,209 @@ struct Command
     const char* help;
     /** @brief Command handler. */
     Handler fn;
+    /** @brief Flag: the command supports the offline mode, see run(). */
+    bool offline = false;
 };
 
 /** @brief Standard message to print after sending request. */
 static const char* completeMessage = "Request has been sent";
 
+/** @brief Standard message to print after editing files in offline mode. */
+static const char* offlineMessage =
+    "Configuration has been written, the network service applies it on start";
+
+/**
+ * @brief Print the standard message and wait for the change to be applied
+ *        if it was requested.
+ *
+ * @param[in] waiter waiter instance
+ */
+static void complete(Waiter& waiter)
+{
+    puts(completeMessage);
+    waiter.wait();
+}
+
+/**
+ * @brief Get current argument as network interface name. In the offline
+ *        mode the interface is looked up in the configuration files instead
+ *        of the kernel: the interface may not exist until the network
+ *        service starts.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] args command arguments
+ *
+ * @throw std::invalid_argument if the argument is not a valid interface
+ * @throw std::exception in case of errors
+ *
+ * @return network interface name
+ */
+static const char* getNetInterface(Dbus& bus, Arguments& args)
+{
+    if (const Networkd* networkd = bus.offline())
+    {
+        const char* iface = args.asText();
+        networkd->loadNetwork(iface);
+        return iface;
+    }
+    return args.asNetInterface();
+}
+
+/**
+ * @brief Function sending asynchronous request for a single item.
+ *
+ * @param[in] index item index
+ * @param[in] onReply reply handler to pass to Dbus::callAsync()
+ * @param[in] onError error handler to pass to Dbus::callAsync()
+ */
+using SendRequest = std::function<void(size_t index, Dbus::ReplyHandler onReply,
+                                       Dbus::ErrorHandler onError)>;
+
+/**
+ * @brief Send requests for several items without waiting for the replies
+ *        one by one, print the result for every item as it arrives.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] items item descriptions, e.g. "VLAN 100"
+ * @param[in] done result description, e.g. "added"
+ * @param[in] send function sending the request
+ *
+ * @throw std::runtime_error if any of the requests failed
+ */
+static void pipeline(Dbus& bus, const std::vector<std::string>& items,
+                     const char* done, const SendRequest& send)
+{
+    // Handlers refer to the counters on this frame
+    Dbus::AsyncScope scope(bus);
+    size_t completed = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        send(
+            i,
+            [&, i](sdbusplus::message::message&) {
+                printf("[%zu/%zu] %s %s\n", ++completed, items.size(),
+                       items[i].c_str(), done);
+            },
+            [&, i](const std::exception& ex) {
+                ++failed;
+                printf("[%zu/%zu] %s failed: %s\n", ++completed, items.size(),
+                       items[i].c_str(), ex.what());
+            });
+    }
+    bus.waitAll();
+
+    if (failed)
+    {
+        std::string err = std::to_string(failed);
+        err += " of ";
+        err += std::to_string(items.size());
+        err += " requests failed";
+        throw std::runtime_error(err);
+    }
+}
+
 /** @brief Show network configuration: `show` */
 static void cmdShow(Dbus& bus, Arguments& args)
 {
+    const bool json = args.takeOption("--json").has_value();
+    const bool jsonLines = args.takeOption("--json-lines").has_value();
+    const bool watch = args.takeOption("--watch").has_value();
+    const auto source = args.takeOption("--source");
+    const bool drift = args.takeOption("--drift").has_value();
+    args.expectEnd();
+
+    const Networkd* offline = bus.offline();
+    if (offline && (watch || source || drift))
+    {
+        throw std::invalid_argument(
+            "--offline can not be combined with --watch, --source or --drift");
+    }
+
+    if (drift)
+    {
+        if (json || jsonLines || watch || source)
+        {
+            throw std::invalid_argument(
+                "--drift can not be combined with other options");
+        }
+        printDrift(bus);
+        return;
+    }
+
+    bool kernel = false;
+    if (source)
+    {
+        kernel = *source == "kernel";
+        if (!kernel && *source != "dbus")
+        {
+            std::string err = "Invalid source: ";
+            err += *source;
+            err += ", expected one of [dbus, kernel]";
+            throw std::invalid_argument(err);
+        }
+    }
+
+    if (watch)
+    {
+        if (json || jsonLines)
+        {
+            throw std::invalid_argument(
+                "--watch can not be combined with JSON output");
+        }
+        if (kernel)
+        {
+            throw std::invalid_argument(
+                "--watch can not be combined with kernel source");
+        }
+        // Fetch the tree once, later it is kept up to date by signals
+        bus.enableCache();
+        Show(bus).watch();
+        return;
+    }
+
+    // Kernel state is read with netlink, D-Bus is never connected, so the
+    // output doesn't depend on the network service being responsive.
+    // Snapshot published by netconfigd is used unless the source is
+    // specified explicitly.
+    std::optional<Dbus::ManagedObject> objects;
+    if (offline)
+    {
+        objects = offline->getObjects();
+    }
+    else if (kernel)
+    {
+        objects = getKernelObjects();
+    }
+    else if (!source)
+    {
+        objects = bus.readSnapshot();
+    }
+    Show show = objects ? Show(bus, std::move(*objects)) : Show(bus);
+    if (json || jsonLines)
+    {
+        show.printJson(jsonLines);
+    }
+    else
+    {
+        show.print();
+    }
+}
+
+/** @brief Print configuration changes as they happen: `monitor [--json]` */
+static void cmdMonitor(Dbus& bus, Arguments& args)
+{
+    const bool json = args.takeOption("--json").has_value();
     args.expectEnd();
-    Show(bus).print();
+    Monitor(bus, json).run();
+}
+
+/** @brief Print a single configuration value: `get SELECTOR` */
+static void cmdGet(Dbus& bus, Arguments& args)
+{
+    const Query query(args.asText());
+    args.expectEnd();
+    query.print(bus);
 }
 
 /** @brief Reset network configuration: `reset` */
@@ -58,103 +264,473 @@ static void cmdReset(Dbus& bus, Arguments& args)
 /** @brief Set MAC address: `mac {INTERFACE} MAC` */
 static void cmdMac(Dbus& bus, Arguments& args)
 {
-    const char* iface = args.asNetInterface();
+    Waiter waiter(bus, args);
+    const char* iface = getNetInterface(bus, args);
     const char* mac = args.asMacAddress();
     args.expectEnd();
 
-    const std::string object = Dbus::ethToPath(iface);
+    const std::string object = bus.ethObject(iface);
+
+    waiter.expectChange(
+        object, Dbus::macInterface,
+        [mac = std::string(mac)](const Dbus::Properties& props) {
+            const auto it = props.find(Dbus::macSet);
+            return it != props.end() &&
+                   std::holds_alternative<std::string>(it->second) &&
+                   strcasecmp(std::get<std::string>(it->second).c_str(),
+                              mac.c_str()) == 0;
+        });
 
     printf("Set new MAC address %s...\n", mac);
     bus.set(Dbus::networkService, object.c_str(), Dbus::macInterface,
             Dbus::macSet, mac);
-    puts(completeMessage);
+    complete(waiter);
 }
 
 /** @brief Set BMC host name: `hostname NAME` */
 static void cmdHostname(Dbus& bus, Arguments& args)
 {
+    Waiter waiter(bus, args);
     std::string name = args.asIpOrFQDN();
     args.expectEnd();
 
     printf("Set new host name %s...\n", name.c_str());
+    if (const Networkd* networkd = bus.offline())
+    {
+        networkd->setHostname(name);
+        puts(offlineMessage);
+        return;
+    }
+
+    waiter.expectChange(Dbus::objectConfig, Dbus::syscfgInterface,
+                        Waiter::equals(Dbus::syscfgHostname, name));
+
     bus.set(Dbus::networkService, Dbus::objectConfig, Dbus::syscfgInterface,
             Dbus::syscfgHostname, name);
-    puts(completeMessage);
+    complete(waiter);
 }
 
 /** @brief Set default gateway: `gateway IP` */
 static void cmdGateway(Dbus& bus, Arguments& args)
 {
-    const auto [ver, ip] = args.asIpAddress();
+    Waiter waiter(bus, args);
+    const IpAddr addr = args.asIpAddress();
     args.expectEnd();
 
+    const IpVer ver = addr.version();
+    const std::string ip = addr.str();
     printf("Setting default gateway for IPv%i to %s...\n",
            static_cast<int>(ver), ip.c_str());
 
+    if (const Networkd* networkd = bus.offline())
+    {
+        networkd->setGateway(addr);
+        puts(offlineMessage);
+        return;
+    }
+
     const char* property =
         ver == IpVer::v4 ? Dbus::syscfgDefGw4 : Dbus::syscfgDefGw6;
 
+    waiter.expectChange(Dbus::objectConfig, Dbus::syscfgInterface,
+                        Waiter::equals(property, ip));
+
     bus.set(Dbus::networkService, Dbus::objectConfig, Dbus::syscfgInterface,
             property, ip);
 
-    puts(completeMessage);
+    complete(waiter);
 }
 
-/** @brief Add/remove IP: `ip {INTERFACE} {add|del} IP[/MASK]` */
-static void cmdIp(Dbus& bus, Arguments& args)
+/**
+ * @brief Get description of IP address with mask.
+ *
+ * @param[in] addr IP address
+ * @param[in] mask mask bits
+ *
+ * @return text in format IP/MASK
+ */
+static std::string ipWithMask(const IpAddr& addr, uint8_t mask)
 {
-    const char* iface = args.asNetInterface();
-    const Action action = args.asAction();
-    const auto [ipVer, ip, mask] = args.asIpAddrMask();
-    args.expectEnd();
-
-    const std::string object = Dbus::ethToPath(iface);
+    return addr.str() + '/' + std::to_string(mask);
+}
 
-    if (action == Action::add)
+/**
+ * @brief Send request for creating static IP address.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] object path to Ethernet object
+ * @param[in] addr IP address
+ * @param[in] mask mask bits
+ * @param[in] onReply reply handler, synchronous call if empty
+ * @param[in] onError error handler
+ *
+ * @throw std::exception in case of errors
+ */
+static void createIp(Dbus& bus, const std::string& object, const IpAddr& addr,
+                     uint8_t mask, Dbus::ReplyHandler onReply = nullptr,
+                     Dbus::ErrorHandler onError = nullptr)
+{
+    const char* ipInterface =
+        addr.version() == IpVer::v4 ? Dbus::ip4Interface : Dbus::ip6Interface;
+    if (onReply)
+    {
+        bus.callAsync(onReply, onError, Dbus::networkService, object.c_str(),
+                      Dbus::ipCreateInterface, Dbus::ipCreateMethod,
+                      ipInterface, addr.str(), mask, "");
+    }
+    else
     {
-        const char* ipInterface =
-            ipVer == IpVer::v4 ? Dbus::ip4Interface : Dbus::ip6Interface;
-
         bus.call(Dbus::networkService, object.c_str(), Dbus::ipCreateInterface,
-                 Dbus::ipCreateMethod, ipInterface, ip, mask, "");
+                 Dbus::ipCreateMethod, ipInterface, addr.str(), mask, "");
+    }
+}
+
+/**
+ * @brief Register expectation of the new IP object.
+ *
+ * @param[in] waiter waiter instance
+ * @param[in] object path to Ethernet object
+ * @param[in] addr IP address
+ * @param[in] mask mask bits
+ */
+static void expectIp(Waiter& waiter, const std::string& object,
+                     const IpAddr& addr, uint8_t mask)
+{
+    waiter.expectObject(object + "/ip", Dbus::ipInterface,
+                        [ip = addr.str(), mask](const Dbus::Properties& p) {
+                            return Waiter::equals(Dbus::ipAddress, ip)(p) &&
+                                   Waiter::equals(Dbus::ipPrefix, mask)(p);
+                        });
+}
 
-        printf("Request for setting %s/%d on %s has been sent\n", ip.c_str(),
-               mask, iface);
+/**
+ * @brief Send requests for removing IP objects.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] waiter waiter instance
+ * @param[in] addresses addresses to remove
+ *
+ * @throw std::exception in case of errors
+ */
+static void removeIps(Dbus& bus, Waiter& waiter,
+                      const std::vector<const Dbus::IpAddress*>& addresses)
+{
+    // The network service handles requests in order of arrival, so the
+    // last one is applied after all others
+    waiter.expectRemoval(addresses.back()->object);
+
+    if (addresses.size() == 1)
+    {
+        bus.call(Dbus::networkService, addresses.front()->object.c_str(),
+                 Dbus::deleteInterface, Dbus::deleteMethod);
     }
     else
     {
-        // Search for IP address' object
-        bool handled = false;
-        for (const auto& it : bus.getAddresses(object.c_str()))
+        std::vector<std::string> items;
+        items.reserve(addresses.size());
+        for (const auto* it : addresses)
         {
-            if (it.address == ip)
-            {
-                bus.call(Dbus::networkService, it.object.c_str(),
-                         Dbus::deleteInterface, Dbus::deleteMethod);
-                handled = true;
-                break;
-            }
+            items.emplace_back("IP " + ipWithMask(it->address, it->mask));
+        }
+        pipeline(bus, items, "removed",
+                 [&](size_t i, Dbus::ReplyHandler onReply,
+                     Dbus::ErrorHandler onError) {
+                     bus.callAsync(onReply, onError, Dbus::networkService,
+                                   addresses[i]->object.c_str(),
+                                   Dbus::deleteInterface, Dbus::deleteMethod);
+                 });
+    }
+
+    complete(waiter);
+}
+
+/**
+ * @class IpIndex
+ * @brief Index of the interface addresses built from a single snapshot.
+ */
+class IpIndex
+{
+  public:
+    /**
+     * @brief Constructor: gets addresses of the interface.
+     *
+     * @param[in] bus D-Bus instance
+     * @param[in] object path to Ethernet object
+     *
+     * @throw std::exception in case of errors
+     */
+    IpIndex(Dbus& bus, const std::string& object) :
+        addresses(bus.getAddresses(object.c_str()))
+    {
+        index.reserve(addresses.size());
+        for (const auto& it : addresses)
+        {
+            index.emplace(it.address, &it);
         }
-        if (!handled)
+    }
+
+    /**
+     * @brief Find the address object.
+     *
+     * @param[in] addr IP address
+     *
+     * @throw std::invalid_argument if address not found
+     *
+     * @return address description
+     */
+    const Dbus::IpAddress* find(const IpAddr& addr) const
+    {
+        const auto it = index.find(addr);
+        if (it == index.end())
         {
             std::string err = "IP address ";
-            err += ip;
+            err += addr.str();
             err += " not found";
             throw std::invalid_argument(err);
         }
+        return it->second;
+    }
 
-        puts(completeMessage);
+    /** @brief All addresses of the interface. */
+    const std::vector<Dbus::IpAddress> addresses;
+
+  private:
+    /** @brief Address to its description. */
+    std::unordered_map<IpAddr, const Dbus::IpAddress*> index;
+};
+
+/**
+ * @brief Edit static IP addresses in the offline mode, all changes are
+ *        written at once.
+ *
+ * @param[in] networkd offline configuration backend
+ * @param[in] iface network interface name
+ * @param[in] action action: add, del, flush or replace
+ * @param[in] args command arguments following the action
+ *
+ * @throw std::exception in case of errors
+ */
+static void ipOffline(const Networkd& networkd, const char* iface,
+                      const char* action, Arguments& args)
+{
+    std::vector<IpAddr> remove;
+    std::vector<std::tuple<IpAddr, uint8_t>> add;
+
+    if (!strcmp(action, "add"))
+    {
+        do
+        {
+            const auto ip = args.asIpAddrMask();
+            if (std::find(add.begin(), add.end(), ip) == add.end())
+            {
+                add.push_back(ip);
+            }
+        } while (args.peek());
+    }
+    else if (!strcmp(action, "del"))
+    {
+        do
+        {
+            const IpAddr ip = std::get<0>(args.asIpAddrMask());
+            if (std::find(remove.begin(), remove.end(), ip) == remove.end())
+            {
+                remove.push_back(ip);
+            }
+        } while (args.peek());
+    }
+    else if (!strcmp(action, "flush"))
+    {
+        std::optional<IpVer> ver;
+        if (args.peek())
+        {
+            ver = !strcmp(args.asOneOf({"v4", "v6"}), "v4") ? IpVer::v4
+                                                            : IpVer::v6;
+        }
+        args.expectEnd();
+
+        for (const auto& [addr, mask] : networkd.getAddresses(iface))
+        {
+            if (!ver || addr.version() == *ver)
+            {
+                remove.push_back(addr);
+            }
+        }
+        if (remove.empty())
+        {
+            puts("No static IP addresses to remove");
+            return;
+        }
+    }
+    else
+    {
+        remove.push_back(std::get<0>(args.asIpAddrMask()));
+        add.emplace_back(args.asIpAddrMask());
+        args.expectEnd();
+    }
+
+    for (const auto& [addr, mask] : add)
+    {
+        printf("Adding IP %s...\n", ipWithMask(addr, mask).c_str());
+    }
+    for (const auto& addr : remove)
+    {
+        printf("Removing IP %s...\n", addr.str().c_str());
+    }
+    networkd.editAddresses(iface, remove, add);
+    puts(offlineMessage);
+}
+
+/**
+ * @brief Add/remove/replace IP:
+ *        `ip {INTERFACE} {add IP[/MASK]...|del IP...|flush [v4|v6]|
+ *         replace OLD NEW[/MASK]}`
+ */
+static void cmdIp(Dbus& bus, Arguments& args)
+{
+    Waiter waiter(bus, args);
+    const char* iface = getNetInterface(bus, args);
+    const char* action = args.asOneOf({"add", "del", "flush", "replace"});
+
+    if (const Networkd* networkd = bus.offline())
+    {
+        ipOffline(*networkd, iface, action, args);
+        return;
+    }
+
+    const std::string object = bus.ethObject(iface);
+
+    if (!strcmp(action, "add"))
+    {
+        // An address listed twice is added once
+        std::vector<std::tuple<IpAddr, uint8_t>> addresses;
+        do
+        {
+            const auto ip = args.asIpAddrMask();
+            if (std::find(addresses.begin(), addresses.end(), ip) ==
+                addresses.end())
+            {
+                addresses.push_back(ip);
+            }
+        } while (args.peek());
+
+        const auto& [lastAddr, lastMask] = addresses.back();
+        expectIp(waiter, object, lastAddr, lastMask);
+
+        if (addresses.size() == 1)
+        {
+            createIp(bus, object, lastAddr, lastMask);
+            printf("Request for setting %s on %s has been sent\n",
+                   ipWithMask(lastAddr, lastMask).c_str(), iface);
+            waiter.wait();
+            return;
+        }
+
+        std::vector<std::string> items;
+        items.reserve(addresses.size());
+        for (const auto& [addr, mask] : addresses)
+        {
+            items.emplace_back("IP " + ipWithMask(addr, mask));
+        }
+        pipeline(bus, items, "added",
+                 [&](size_t i, Dbus::ReplyHandler onReply,
+                     Dbus::ErrorHandler onError) {
+                     const auto& [addr, mask] = addresses[i];
+                     createIp(bus, object, addr, mask, onReply, onError);
+                 });
+        complete(waiter);
+    }
+    else if (!strcmp(action, "del"))
+    {
+        std::vector<IpAddr> targets;
+        do
+        {
+            targets.emplace_back(std::get<0>(args.asIpAddrMask()));
+        } while (args.peek());
+
+        // All targets are resolved before sending anything, an address
+        // listed twice is removed once
+        const IpIndex index(bus, object);
+        std::vector<const Dbus::IpAddress*> addresses;
+        std::unordered_set<const Dbus::IpAddress*> unique;
+        addresses.reserve(targets.size());
+        for (const auto& addr : targets)
+        {
+            const Dbus::IpAddress* ip = index.find(addr);
+            if (unique.insert(ip).second)
+            {
+                addresses.push_back(ip);
+            }
+        }
+
+        removeIps(bus, waiter, addresses);
+    }
+    else if (!strcmp(action, "flush"))
+    {
+        std::optional<IpVer> ver;
+        if (args.peek())
+        {
+            ver = !strcmp(args.asOneOf({"v4", "v6"}), "v4") ? IpVer::v4
+                                                            : IpVer::v6;
+        }
+        args.expectEnd();
+
+        // Only static addresses can be removed, others are managed by the
+        // network service itself (DHCP, link-local)
+        const IpIndex index(bus, object);
+        std::vector<const Dbus::IpAddress*> addresses;
+        for (const auto& it : index.addresses)
+        {
+            if ((!ver || it.address.version() == *ver) &&
+                (it.origin.empty() || it.origin == Dbus::ipOriginStatic))
+            {
+                addresses.push_back(&it);
+            }
+        }
+        if (addresses.empty())
+        {
+            puts("No static IP addresses to remove");
+            return;
+        }
+
+        removeIps(bus, waiter, addresses);
+    }
+    else
+    {
+        const IpAddr oldAddr = std::get<0>(args.asIpAddrMask());
+        const auto [newAddr, newMask] = args.asIpAddrMask();
+        args.expectEnd();
+
+        const IpIndex index(bus, object);
+        const Dbus::IpAddress* old = index.find(oldAddr);
+
+        // The new address is added first and the old one is removed only if
+        // that succeeded, so the management plane stays reachable
+        printf("Adding IP %s...\n", ipWithMask(newAddr, newMask).c_str());
+        createIp(bus, object, newAddr, newMask);
+        printf("Removing IP %s...\n",
+               ipWithMask(old->address, old->mask).c_str());
+        removeIps(bus, waiter, {old});
     }
 }
 
 /** @brief Enable/disable DHCP client: 'dhcp {INTERFACE} {enable|disable}` */
 static void cmdDhcp(Dbus& bus, Arguments& args)
 {
-    const char* iface = args.asNetInterface();
+    Waiter waiter(bus, args);
+    const char* iface = getNetInterface(bus, args);
     const Toggle toggle = args.asToggle();
     args.expectEnd();
 
-    const std::string object = Dbus::ethToPath(iface);
+    if (const Networkd* networkd = bus.offline())
+    {
+        printf("%s DHCP client...\n",
+               toggle == Toggle::enable ? "Enable" : "Disable");
+        networkd->setDhcp(iface, toggle == Toggle::enable);
+        puts(offlineMessage);
+        return;
+    }
+
+    const std::string object = bus.ethObject(iface);
     std::string enable;
 
     switch (toggle)
@@ -170,13 +746,16 @@ static void cmdDhcp(Dbus& bus, Arguments& args)
             break;
     }
 
+    waiter.expectChange(object, Dbus::ethInterface,
+                        Waiter::equals(Dbus::ethDhcpEnabled, enable));
+
     printf("%s DHCP client...\n",
            toggle == Toggle::enable ? "Enable" : "Disable");
 
     bus.set(Dbus::networkService, object.c_str(), Dbus::ethInterface,
             Dbus::ethDhcpEnabled, enable);
 
-    puts(completeMessage);
+    complete(waiter);
 }
 
 /** @brief Enable/disable DHCP features: 'dhcpcfg {enable|disable} {dns|ntp}` */
@@ -207,67 +786,156 @@ static void cmdDhcpcfg(Dbus& bus, Arguments& args)
     puts(completeMessage);
 }
 
-/** @brief Add/remove DNS server: `dns {INTERFACE} {add|del} IP [IP..]` */
-static void cmdDns(Dbus& bus, Arguments& args)
+/**
+ * @brief Create check function for the list of servers.
+ *
+ * @param[in] name property name
+ * @param[in] servers list of added/removed servers
+ * @param[in] action action type
+ *
+ * @return check function
+ */
+static Waiter::Check serversCheck(const char* name,
+                                  const std::vector<std::string>& servers,
+                                  Action action)
 {
-    const char* iface = args.asNetInterface();
-    const Action action = args.asAction();
+    return [name = std::string(name), servers,
+            action](const Dbus::Properties& props) {
+        const auto it = props.find(name);
+        if (it == props.end() ||
+            !std::holds_alternative<std::vector<std::string>>(it->second))
+        {
+            return false;
+        }
+        const auto& current = std::get<std::vector<std::string>>(it->second);
+        return std::all_of(
+            servers.begin(), servers.end(), [&](const std::string& srv) {
+                const bool found = std::find(current.begin(), current.end(),
+                                             srv) != current.end();
+                return found == (action == Action::add);
+            });
+    };
+}
+
+/**
+ * @brief Edit list of servers: add, remove or replace the whole list.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] args command arguments starting with the action
+ * @param[in] kind servers kind for messages and the networkd key, e.g. "DNS"
+ * @param[in] property name of the servers list property
+ * @param[in] parse function extracting single server from the arguments
+ *
+ * @throw std::exception in case of errors
+ */
+static void editServers(Dbus& bus, Arguments& args, const char* kind,
+                        const char* property,
+                        std::string (*parse)(Arguments& args))
+{
+    Waiter waiter(bus, args);
+    const char* iface = getNetInterface(bus, args);
+    const char* action = args.asOneOf({"add", "del", "replace"});
+    const bool replace = !strcmp(action, "replace");
 
     std::vector<std::string> servers;
     while (args.peek() != nullptr)
     {
-        const auto [_, srv] = args.asIpAddress();
-        servers.emplace_back(srv);
-        printf("%s DNS server %s...\n",
-               action == Action::add ? "Adding" : "Removing", srv.c_str());
+        std::string srv = parse(args);
+        if (!replace)
+        {
+            printf("%s %s server %s...\n",
+                   !strcmp(action, "add") ? "Adding" : "Removing", kind,
+                   srv.c_str());
+        }
+        servers.emplace_back(std::move(srv));
     }
     args.expectEnd();
 
-    const std::string object = Dbus::ethToPath(iface);
-    if (action == Action::add)
+    if (replace)
     {
-        bus.append(Dbus::networkService, object.c_str(), Dbus::ethInterface,
-                   Dbus::ethStNameServers, servers);
+        printf("Setting %s servers to [", kind);
+        for (size_t i = 0; i < servers.size(); ++i)
+        {
+            printf("%s%s", i ? ", " : "", servers[i].c_str());
+        }
+        puts("]...");
     }
-    else
+
+    if (const Networkd* networkd = bus.offline())
     {
-        bus.remove(Dbus::networkService, object.c_str(), Dbus::ethInterface,
-                   Dbus::ethStNameServers, servers);
+        std::vector<std::string> list;
+        if (replace)
+        {
+            list = servers;
+        }
+        else
+        {
+            const bool add = !strcmp(action, "add");
+            list = networkd->getServers(iface, kind);
+            for (const auto& srv : servers)
+            {
+                const auto it = std::find(list.begin(), list.end(), srv);
+                if (add && it == list.end())
+                {
+                    list.push_back(srv);
+                }
+                else if (!add && it != list.end())
+                {
+                    list.erase(it);
+                }
+            }
+        }
+        networkd->setServers(iface, kind, list);
+        puts(offlineMessage);
+        return;
     }
 
-    puts(completeMessage);
-}
-
-/** @brief Add/remove NTP server: `ntp {INTERFACE} {add|del} ADDR [ADDR..]` */
-static void cmdNtp(Dbus& bus, Arguments& args)
-{
-    const char* iface = args.asNetInterface();
-    const Action action = args.asAction();
+    const std::string object = bus.ethObject(iface);
 
-    std::vector<std::string> servers;
-    while (args.peek() != nullptr)
+    if (replace)
     {
-        std::string srv = args.asIpOrFQDN();
-        printf("%s NTP server %s...\n",
-               action == Action::add ? "Adding" : "Removing", srv.c_str());
-        servers.emplace_back(srv);
+        // The whole list is written with a single Set, no read is needed
+        waiter.expectChange(object, Dbus::ethInterface,
+                            Waiter::equals(property, servers));
+        bus.set(Dbus::networkService, object.c_str(), Dbus::ethInterface,
+                property, servers);
     }
-    args.expectEnd();
-
-    const std::string object = Dbus::ethToPath(iface);
-
-    if (action == Action::add)
+    else if (!strcmp(action, "add"))
     {
+        waiter.expectChange(object, Dbus::ethInterface,
+                            serversCheck(property, servers, Action::add));
         bus.append(Dbus::networkService, object.c_str(), Dbus::ethInterface,
-                   Dbus::ethNtpServers, servers);
+                   property, servers);
     }
     else
     {
+        waiter.expectChange(object, Dbus::ethInterface,
+                            serversCheck(property, servers, Action::del));
         bus.remove(Dbus::networkService, object.c_str(), Dbus::ethInterface,
-                   Dbus::ethNtpServers, servers);
+                   property, servers);
     }
 
-    puts(completeMessage);
+    complete(waiter);
+}
+
+/**
+ * @brief Add/remove/replace DNS servers:
+ *        `dns {INTERFACE} {add|del|replace} IP [IP..]`
+ */
+static void cmdDns(Dbus& bus, Arguments& args)
+{
+    editServers(bus, args, "DNS", Dbus::ethStNameServers,
+                [](Arguments& args) { return args.asIpAddress().str(); });
+}
+
+/**
+ * @brief Add/remove/replace NTP servers:
+ *        `ntp {INTERFACE} {add|del|replace} ADDR [ADDR..]`
+ */
+static void cmdNtp(Dbus& bus, Arguments& args)
+{
+    editServers(bus, args, "NTP", Dbus::ethNtpServers,
+                [](Arguments& args) { return args.asIpOrFQDN(); });
 }
 
 /** @brief Check VLAN ID for IEEE 802.1Q conformance */
@@ -280,31 +948,156 @@ static void checkVlanId(const uint32_t id)
     }
 }
 
-/** @brief Add/remove VLAN: `vlan {add|del} {INTERFACE} ID` */
+/**
+ * @brief Add/remove several VLANs. VLANs that are already in the requested
+ *        state are skipped, requests for the rest are pipelined.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] waiter waiter instance
+ * @param[in] action action to perform
+ * @param[in] iface parent network interface name
+ * @param[in] ids VLAN IDs
+ *
+ * @throw std::exception in case of errors
+ */
+static void vlanBulk(Dbus& bus, Waiter& waiter, Action action,
+                     const char* iface, const std::vector<uint32_t>& ids)
+{
+    const bool add = action == Action::add;
+    const std::string prefix = bus.ethObject(iface) + '_';
+
+    const Dbus::ManagedObject objects =
+        bus.getManagedObjects({Dbus::vlanInterface});
+    std::vector<uint32_t> todo;
+    for (const uint32_t id : ids)
+    {
+        const bool exists =
+            objects.find(prefix + std::to_string(id)) != objects.end();
+        if (exists != add)
+        {
+            todo.push_back(id);
+        }
+    }
+
+    printf("%s %zu VLANs on %s", add ? "Adding" : "Removing", todo.size(),
+           iface);
+    if (todo.size() != ids.size())
+    {
+        printf(", %zu skipped as %s", ids.size() - todo.size(),
+               add ? "existing" : "nonexistent");
+    }
+    puts("...");
+    if (todo.empty())
+    {
+        return;
+    }
+
+    // The network service handles requests in order of arrival, so the
+    // last one is applied after all others
+    const std::string last = prefix + std::to_string(todo.back());
+    if (add)
+    {
+        waiter.expectChange(last, Dbus::vlanInterface,
+                            Waiter::equals(Dbus::vlanId, todo.back()));
+    }
+    else
+    {
+        waiter.expectRemoval(last);
+    }
+
+    std::vector<std::string> items;
+    items.reserve(todo.size());
+    for (const uint32_t id : todo)
+    {
+        items.emplace_back("VLAN " + std::to_string(id));
+    }
+    pipeline(bus, items, add ? "added" : "removed",
+             [&](size_t i, Dbus::ReplyHandler onReply,
+                 Dbus::ErrorHandler onError) {
+                 if (add)
+                 {
+                     bus.callAsync(onReply, onError, Dbus::networkService,
+                                   Dbus::objectRoot, Dbus::vlanCreateInterface,
+                                   Dbus::vlanCreateMethod, iface, todo[i]);
+                 }
+                 else
+                 {
+                     const std::string object =
+                         prefix + std::to_string(todo[i]);
+                     bus.callAsync(onReply, onError, Dbus::networkService,
+                                   object.c_str(), Dbus::deleteInterface,
+                                   Dbus::deleteMethod);
+                 }
+             });
+
+    complete(waiter);
+}
+
+/** @brief Add/remove VLAN: `vlan {add|del} {INTERFACE} ID[-ID][,...]` */
 static void cmdVlan(Dbus& bus, Arguments& args)
 {
+    Waiter waiter(bus, args);
     const Action action = args.asAction();
-    const char* iface = args.asNetInterface();
-    const uint32_t id = static_cast<uint32_t>(args.asNumber());
+    const char* iface = getNetInterface(bus, args);
+    const auto ranges = args.asRanges();
     args.expectEnd();
 
-    checkVlanId(id);
+    // Ranges are sorted, so checking the bounds validates the whole list
+    checkVlanId(ranges.front().first);
+    checkVlanId(ranges.back().second);
+
+    std::vector<uint32_t> ids;
+    for (const auto& [first, last] : ranges)
+    {
+        for (uint32_t id = first; id <= last; ++id)
+        {
+            ids.push_back(id);
+        }
+    }
+
+    if (const Networkd* networkd = bus.offline())
+    {
+        const bool add = action == Action::add;
+        const size_t done = add ? networkd->addVlans(iface, ids)
+                                : networkd->removeVlans(iface, ids);
+        printf("%s %zu VLANs on %s", add ? "Added" : "Removed", done, iface);
+        if (done != ids.size())
+        {
+            printf(", %zu skipped as %s", ids.size() - done,
+                   add ? "existing" : "nonexistent");
+        }
+        puts("");
+        puts(offlineMessage);
+        return;
+    }
+
+    if (ids.size() > 1)
+    {
+        vlanBulk(bus, waiter, action, iface, ids);
+        return;
+    }
+
+    const uint32_t id = ids.front();
 
     printf("%s VLAN with ID %u...\n",
            action == Action::add ? "Adding" : "Removing", id);
 
+    const std::string object =
+        bus.ethObject(iface) + '_' + std::to_string(id);
+
     try
     {
         if (action == Action::add)
         {
+            waiter.expectChange(object, Dbus::vlanInterface,
+                                Waiter::equals(Dbus::vlanId, id));
             bus.call(Dbus::networkService, Dbus::objectRoot,
                      Dbus::vlanCreateInterface, Dbus::vlanCreateMethod, iface,
                      id);
         }
         else
         {
-            const std::string object =
-                Dbus::ethToPath(iface) + '_' + std::to_string(id);
+            waiter.expectRemoval(object);
             bus.call(Dbus::networkService, object.c_str(),
                      Dbus::deleteInterface, Dbus::deleteMethod);
         }
@@ -319,7 +1112,7 @@ static void cmdVlan(Dbus& bus, Arguments& args)
         throw;
     }
 
-    puts(completeMessage);
+    complete(waiter);
 }
 
 /** @brief Configure remote syslog server: `set ADDR[:PORT]` */
@@ -333,36 +1126,51 @@ static void cmdSyslogSet(Dbus& bus, Arguments& args)
     }
 
     printf("Set remote syslog server %s:%u...\n", addr.c_str(), port);
-    bus.set(Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface,
-            Dbus::syslogAddr, addr);
-    bus.set(Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface,
-            Dbus::syslogPort, port);
-    puts(completeMessage);
+    if (bus.setSyslog(addr, port))
+    {
+        puts(completeMessage);
+    }
+    else
+    {
+        puts("Remote syslog server is already configured");
+    }
 }
 
 /** @brief Reset syslog settings: `reset` */
 static void cmdSyslogReset(Dbus& bus, Arguments& args)
 {
-    std::string addr{""};
-    unsigned short port{0};
     args.expectEnd();
-    bus.set(Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface,
-            Dbus::syslogAddr, addr);
-    bus.set(Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface,
-            Dbus::syslogPort, port);
+    bus.setSyslog("", 0);
     puts(completeMessage);
 }
 
 /** @brief Show the configured remote syslog server: `show` */
 static void cmdSyslogShow(Dbus& bus, Arguments& args)
 {
+    const bool json = args.takeOption("--json").has_value();
+    const bool jsonLines = args.takeOption("--json-lines").has_value();
     args.expectEnd();
-    std::string addr =
-        bus.get<std::string>(Dbus::syslogService, Dbus::objectSyslog,
-                             Dbus::syslogInterface, Dbus::syslogAddr);
-    unsigned short port =
-        bus.get<unsigned short>(Dbus::syslogService, Dbus::objectSyslog,
-                                Dbus::syslogInterface, Dbus::syslogPort);
+    const auto [addr, port] = bus.getSyslog();
+
+    Stats::Timer timer(Stats::render);
+    if (json || jsonLines)
+    {
+        // A single record is the same in both formats
+        JsonWriter writer;
+        writer.beginObject();
+        if (addr.empty() || port == 0)
+        {
+            writer.key("address").null();
+            writer.key("port").null();
+        }
+        else
+        {
+            writer.key("address").string(addr);
+            writer.key("port").number(port);
+        }
+        writer.endObject().endLine();
+        return;
+    }
 
     printf("Remote syslog server: ");
     if (addr == "" || port == 0)
@@ -378,23 +1186,25 @@ static void cmdSyslogShow(Dbus& bus, Arguments& args)
 // clang-format off
 /** @brief List of command descriptions. */
 static const Command ifconfigCommands[] = {
-    {"show", nullptr, "Show current configuration", cmdShow},
+    {"show", "[--json|--json-lines|--watch] [--source={dbus|kernel}|--offline] | --drift", "Show current configuration, --watch keeps it updated, kernel source reads interfaces state with netlink bypassing the network service, --offline reads the files persisted by the network service, --drift prints only differences between the network service and the kernel", cmdShow, true},
+    {"get", "SELECTOR", Query::help, cmdGet},
+    {"monitor", "[--json]", "Print configuration changes as they happen: one event per line with a monotonic timestamp and the time since the previous event of the same interface", cmdMonitor},
     {"reset", nullptr, "Reset configuration to factory defaults", cmdReset},
-    {"mac", "{INTERFACE} MAC", "Set MAC address", cmdMac},
-    {"hostname", "NAME", "Set host name", cmdHostname},
-    {"gateway", "IP", "Set default gateway", cmdGateway},
-    {"ip", "{INTERFACE} {add|del} IP[/MASK]", "Add or remove static IP address (default mask: IPv4/24, IPv6/64)", cmdIp},
-    {"dhcp", "{INTERFACE} {enable|disable}", "Enable or disable DHCP client", cmdDhcp},
+    {"mac", "{INTERFACE} MAC [--wait[=TIMEOUT]]", "Set MAC address", cmdMac},
+    {"hostname", "NAME [--wait[=TIMEOUT]|--offline]", "Set host name", cmdHostname, true},
+    {"gateway", "IP [--wait[=TIMEOUT]|--offline]", "Set default gateway", cmdGateway, true},
+    {"ip", "{INTERFACE} {add IP[/MASK]...|del IP...|flush [v4|v6]|replace OLD NEW[/MASK]} [--wait[=TIMEOUT]|--offline]", "Add, remove or replace static IP addresses (default mask: IPv4/24, IPv6/64), flush removes all static addresses", cmdIp, true},
+    {"dhcp", "{INTERFACE} {enable|disable} [--wait[=TIMEOUT]|--offline]", "Enable or disable DHCP client", cmdDhcp, true},
     {"dhcpcfg", "{enable|disable} {dns|ntp}", "Enable or disable DHCP features", cmdDhcpcfg},
-    {"dns", "{INTERFACE} {add|del} IP [IP..]", "Add or remove DNS server", cmdDns},
-    {"ntp", "{INTERFACE} {add|del} ADDR [ADDR..]", "Add or remove NTP server", cmdNtp},
-    {"vlan", "{add|del} {INTERFACE} ID", "Add or remove VLAN", cmdVlan},
+    {"dns", "{INTERFACE} {add|del|replace} IP [IP..] [--wait[=TIMEOUT]|--offline]", "Add or remove DNS servers, or replace the whole list", cmdDns, true},
+    {"ntp", "{INTERFACE} {add|del|replace} ADDR [ADDR..] [--wait[=TIMEOUT]|--offline]", "Add or remove NTP servers, or replace the whole list", cmdNtp, true},
+    {"vlan", "{add|del} {INTERFACE} ID[-ID][,...] [--wait[=TIMEOUT]|--offline]", "Add or remove VLANs, e.g. 100-199,300", cmdVlan, true},
 };
 
 static const Command syslogCommands[] = {
     {"set", "ADDR[:PORT]", "Configure remote syslog server (Address and an optional TCP port (default is 514))", cmdSyslogSet},
     {"reset", nullptr, "Reset syslog settings. Alias for the syslog set command without arguments.", cmdSyslogReset},
-    {"show", nullptr, "Show the configured remote syslog server", cmdSyslogShow},
+    {"show", "[--json|--json-lines]", "Show the configured remote syslog server", cmdSyslogShow},
 };
 // clang-format on
 
@@ -405,12 +1215,13 @@ static std::tuple<const Command*, unsigned int>
     unsigned int arrSize;
 
     if (!strcmp(app, cliIfconfig) || !strcmp(app, cliDatetime) ||
-        !strcmp(app, rootIfconfig))
+        !strcmp(app, rootIfconfig) || !strcmp(app, ifcfg))
     {
         cmdArr = ifconfigCommands;
         arrSize = sizeof(ifconfigCommands) / sizeof(Command);
     }
-    else if (!strcmp(app, cliSyslog) || !strcmp(app, rootSyslog))
+    else if (!strcmp(app, cliSyslog) || !strcmp(app, rootSyslog) ||
+             !strcmp(app, sslg))
     {
         cmdArr = syslogCommands;
         arrSize = sizeof(syslogCommands) / sizeof(Command);
@@ -425,9 +1236,18 @@ static std::tuple<const Command*, unsigned int>
     return std::make_tuple(cmdArr, arrSize);
 }
 
-void execute(const char* app, Arguments& args)
+/**
+ * @brief Search for the command description.
+ *
+ * @param[in] app     application name
+ * @param[in] cmdName command name
+ *
+ * @throw std::invalid_argument if command not found
+ *
+ * @return pointer to the command description
+ */
+static const Command* findCommand(const char* app, const char* cmdName)
 {
-    const char* cmdName = args.asText();
     std::tuple<const Command*, unsigned short> cmds = getCommandsArray(app);
 
     for (const auto* it = std::get<0>(cmds);
@@ -435,9 +1255,7 @@ void execute(const char* app, Arguments& args)
     {
         if (strcmp(cmdName, it->name) == 0)
         {
-            Dbus bus;
-            it->fn(bus, args);
-            return;
+            return it;
         }
     }
 
@@ -446,6 +1264,131 @@ void execute(const char* app, Arguments& args)
     throw std::invalid_argument(err);
 }
 
+/**
+ * @brief Run the command handler. With `--offline` option the handler gets
+ *        a D-Bus instance that never connects and edits the files persisted
+ *        by the network service instead.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] cmd command description
+ * @param[in] args command arguments without command name itself
+ *
+ * @throw std::exception in case of errors
+ */
+static void run(Dbus& bus, const Command* cmd, Arguments& args)
+{
+    if (!args.takeOption("--offline"))
+    {
+        cmd->fn(bus, args);
+        return;
+    }
+    if (!cmd->offline)
+    {
+        std::string err = "Command ";
+        err += cmd->name;
+        err += " does not support the offline mode";
+        throw std::invalid_argument(err);
+    }
+    if (args.takeOption("--wait"))
+    {
+        throw std::invalid_argument(
+            "--wait can not be combined with --offline");
+    }
+
+    Networkd networkd(NETWORKD_DIR, Networkd::defaultHostnameFile);
+    Dbus offline(networkd);
+    cmd->fn(offline, args);
+}
+
+void execute(const char* app, Arguments& args)
+{
+    const Command* cmd = findCommand(app, args.asText());
+    Dbus bus;
+    run(bus, cmd, args);
+}
+
+void execute(Dbus& bus, const char* app, Arguments& args)
+{
+    const Command* cmd = findCommand(app, args.asText());
+    run(bus, cmd, args);
+}
+
+bool isLongRunning(const Arguments& args)
+{
+    const auto tail = args.tail();
+    if (!tail.empty() && !strcmp(tail.front(), "monitor"))
+    {
+        return true;
+    }
+    for (const char* arg : tail)
+    {
+        if (!strcmp(arg, "--watch") || !strcmp(arg, "--wait") ||
+            !strncmp(arg, "--wait=", 7))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isOffline(const Arguments& args)
+{
+    for (const char* arg : args.tail())
+    {
+        if (!strcmp(arg, "--offline"))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isSnapshotRead(const char* app, const Arguments& args)
+{
+    const auto tail = args.tail();
+    if (tail.empty() || std::get<0>(getCommandsArray(app)) != ifconfigCommands)
+    {
+        return false;
+    }
+    if (!strcmp(tail.front(), "get"))
+    {
+        return true;
+    }
+    if (strcmp(tail.front(), "show"))
+    {
+        return false;
+    }
+    // Other options need live data
+    for (size_t i = 1; i < tail.size(); ++i)
+    {
+        if (strcmp(tail[i], "--json") && strcmp(tail[i], "--json-lines"))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printError(const std::exception& ex)
+{
+    const std::string what = ex.what();
+    if (dynamic_cast<const sdbusplus::exception::SdBusError*>(&ex))
+    {
+        if (what.find("UnreachableGW") != std::string::npos)
+        {
+            fprintf(stderr, "Unreachable gateway specified\n");
+            return;
+        }
+        if (what.find("NotAllowed") != std::string::npos)
+        {
+            fprintf(stderr, "The operation is not allowed because no static "
+                            "addresses found\n");
+            return;
+        }
+    }
+    fprintf(stderr, "%s\n", what.c_str());
+}
+
 void help(CLIMode mode, const char* app, Arguments& args)
 {
     const char* helpForCmd = args.peek();
@@ -5,6 +5,10 @@
 
 #include "arguments.hpp"
 
+#include <exception>
+
+class Dbus;
+
 /**
  * @brief Execute the configuration command.
  *
@@ -15,6 +19,61 @@
  */
 void execute(const char* app, Arguments& args);
 
+/**
+ * @brief Execute the configuration command using existing D-Bus connection.
+ *
+ * @param[in] bus  D-Bus instance
+ * @param[in] app  application name
+ * @param[in] args command line arguments
+ *
+ * @throw std::exception in case of errors
+ */
+void execute(Dbus& bus, const char* app, Arguments& args);
+
+/**
+ * @brief Check if the command may run for a long time: watches for changes
+ *        until interrupted or waits for the change to be applied. Such
+ *        commands are never executed by netconfigd as that would block the
+ *        daemon.
+ *
+ * @param[in] args command line arguments
+ *
+ * @return true if the command may block for a long time
+ */
+bool isLongRunning(const Arguments& args);
+
+/**
+ * @brief Check if the command runs in the offline mode: edits the files
+ *        persisted by the network service instead of calling it. Such
+ *        commands are never executed by netconfigd, the daemon needs the
+ *        network service.
+ *
+ * @param[in] args command line arguments
+ *
+ * @return true if the command runs in the offline mode
+ */
+bool isOffline(const Arguments& args);
+
+/**
+ * @brief Check if the command only reads network objects, which can be
+ *        served from the snapshot published by netconfigd in shared memory.
+ *        Such commands are executed locally: reading the snapshot is
+ *        cheaper than a request to the daemon.
+ *
+ * @param[in] app  application name
+ * @param[in] args command line arguments
+ *
+ * @return true if the command can be served from the snapshot
+ */
+bool isSnapshotRead(const char* app, const Arguments& args);
+
+/**
+ * @brief Print error description to stderr.
+ *
+ * @param[in] ex exception caught while executing the command
+ */
+void printError(const std::exception& ex);
+
 enum class CLIMode {
   normalMode, ///< Normal mode, print the banner and the command name in help
   cliMode, ///< CLI mode, do not print banner, print command name in help
@@ -38,6 +97,9 @@ static constexpr uint32_t maxVlanId = 4094;
 static constexpr const char* netCnfg = "netconfig";
 static constexpr const char* ifcfg = "ifconfig";
 static constexpr const char* sslg = "syslog";
+static constexpr const char* btch = "batch";
+static constexpr const char* aply = "apply";
+static constexpr const char* shll = "shell";
 static constexpr const char* cliIfconfig = "bmc ifconfig";
 static constexpr const char* rootIfconfig = "netconfig ifconfig";
 static constexpr const char* cliSyslog = "bmc syslog";
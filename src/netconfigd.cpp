@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "client.hpp"
+#include "config.hpp"
+#include "dbus.hpp"
+#include "netconfig.hpp"
+#include "netifaces.hpp"
+#include "snapshot.hpp"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+/** @brief Max time to wait for the client's request, in seconds. */
+static constexpr time_t requestTimeout = 1;
+/** @brief Max time to send the reply to the client. */
+static constexpr std::chrono::seconds replyTimeout(5);
+
+/**
+ * @brief Open listening socket.
+ *
+ * @throw std::system_error in case of errors
+ *
+ * @return socket descriptor
+ */
+static int openSocket()
+{
+    const int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), "socket");
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, NETCONFIGD_SOCKET, sizeof(addr.sun_path) - 1);
+    unlink(addr.sun_path);
+
+    // Only root is allowed to configure network
+    const mode_t mask = umask(0077);
+    const int rc =
+        bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    umask(mask);
+    if (rc == -1 || listen(sock, SOMAXCONN) == -1)
+    {
+        const int err = errno;
+        close(sock);
+        throw std::system_error(err, std::generic_category(),
+                                NETCONFIGD_SOCKET);
+    }
+
+    return sock;
+}
+
+/**
+ * @brief Execute the command with output redirected to the files.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] request request data: NUL-terminated application name and
+ *                    arguments
+ * @param[in] fds files to collect stdout and stderr of the command
+ *
+ * @return exit status of the command
+ */
+static int32_t executeRequest(Dbus& bus, std::string& request,
+                              const int (&fds)[2])
+{
+    std::vector<char*> argv;
+    for (size_t pos = 0; pos < request.size();
+         pos = request.find('\0', pos) + 1)
+    {
+        argv.push_back(&request[pos]);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    const int savedOut = dup(STDOUT_FILENO);
+    const int savedErr = dup(STDERR_FILENO);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+
+    int32_t status = EXIT_SUCCESS;
+    try
+    {
+        Arguments args(static_cast<int>(argv.size()), argv.data());
+        const char* app = args.asText();
+        if (isLongRunning(args))
+        {
+            throw std::invalid_argument(
+                "The command can not be executed by the daemon");
+        }
+        // Interfaces may have been added or removed since the last request
+        NetIfaces::instance().reset();
+        execute(bus, app, args);
+    }
+    catch (const std::exception& ex)
+    {
+        printError(ex);
+        status = EXIT_FAILURE;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(savedOut, STDOUT_FILENO);
+    dup2(savedErr, STDERR_FILENO);
+    close(savedOut);
+    close(savedErr);
+
+    return status;
+}
+
+/**
+ * @brief Send reply packet to the client.
+ *
+ * @param[in] conn connection socket
+ * @param[in] deadline time to give up if the client doesn't read the reply
+ * @param[in] type packet type
+ * @param[in] data packet payload
+ * @param[in] size payload size, up to maxChunkSize
+ *
+ * @return false if the packet can not be sent
+ */
+static bool sendReply(int conn, std::chrono::steady_clock::time_point deadline,
+                      Reply type, const void* data, size_t size)
+{
+    using namespace std::chrono;
+
+    char packet[1 + maxChunkSize];
+    packet[0] = static_cast<char>(type);
+    if (size)
+    {
+        memcpy(packet + 1, data, size);
+    }
+
+    while (true)
+    {
+        const ssize_t rc =
+            send(conn, packet, size + 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (rc != -1)
+        {
+            return true;
+        }
+        if (errno != EAGAIN && errno != EINTR)
+        {
+            return false;
+        }
+        const auto remain =
+            duration_cast<milliseconds>(deadline - steady_clock::now());
+        pollfd pfd = {conn, POLLOUT, 0};
+        if (remain.count() <= 0 ||
+            poll(&pfd, 1, static_cast<int>(remain.count())) == 0)
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Send collected output of the command to the client.
+ *
+ * @param[in] conn connection socket
+ * @param[in] deadline time to give up if the client doesn't read the reply
+ * @param[in] type packet type: stdout or stderr chunk
+ * @param[in] fd file with the collected output
+ *
+ * @return false if the output can not be sent
+ */
+static bool sendOutput(int conn, std::chrono::steady_clock::time_point deadline,
+                       Reply type, int fd)
+{
+    char chunk[maxChunkSize];
+    ssize_t len;
+    lseek(fd, 0, SEEK_SET);
+    while ((len = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        if (!sendReply(conn, deadline, type, chunk, len))
+        {
+            return false;
+        }
+    }
+    return len == 0;
+}
+
+/**
+ * @brief Handle client's connection.
+ *
+ * The output of the command is collected in memory and sent over the
+ * socket, the daemon never writes to the client's descriptors: a client
+ * that doesn't read its output would block the daemon.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] conn connection socket
+ */
+static void handleClient(Dbus& bus, int conn)
+{
+    // The client sends its request only after this, so it may give up
+    // waiting for a busy daemon and run the command by itself
+    if (!sendReply(conn, std::chrono::steady_clock::now(), Reply::ready,
+                   nullptr, 0))
+    {
+        return;
+    }
+
+    // The daemon serves clients one by one, a client that never sends its
+    // request must not block the others and the mirror updates.
+    // Descriptors passed with the request are discarded by the kernel as
+    // no control buffer is provided.
+    const timeval timeout = {requestTimeout, 0};
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string request(maxRequestSize, '\0');
+    const ssize_t rc = recv(conn, request.data(), request.size(), 0);
+    if (rc <= 0)
+    {
+        return;
+    }
+    if (request[rc - 1] != '\0')
+    {
+        fprintf(stderr, "Invalid request\n");
+        return;
+    }
+    request.resize(rc);
+
+    const int fds[2] = {memfd_create("stdout", MFD_CLOEXEC),
+                        memfd_create("stderr", MFD_CLOEXEC)};
+    if (fds[0] != -1 && fds[1] != -1)
+    {
+        const int32_t status = executeRequest(bus, request, fds);
+        const auto deadline = std::chrono::steady_clock::now() + replyTimeout;
+        if (!sendOutput(conn, deadline, Reply::out, fds[0]) ||
+            !sendOutput(conn, deadline, Reply::err, fds[1]) ||
+            !sendReply(conn, deadline, Reply::status, &status, sizeof(status)))
+        {
+            fprintf(stderr, "Unable to send reply\n");
+        }
+    }
+    else
+    {
+        perror("memfd_create");
+    }
+
+    for (const int fd : fds)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+/** @brief Daemon entry point. */
+int main()
+{
+    // Client may close its output at any time
+    signal(SIGPIPE, SIG_IGN);
+
+    try
+    {
+        Dbus bus;
+
+        // Every change of the mirror is published for readers in shared
+        // memory, a batch of signals is published at once
+        Snapshot snapshot(NETCONFIG_SNAPSHOT);
+        bool changed = true;
+        bus.observeCache([&changed](const std::string&) { changed = true; });
+
+        const int srv = openSocket();
+
+        while (true)
+        {
+            // Apply all pending changes to the objects mirror
+            bus.process();
+            if (changed)
+            {
+                snapshot.publish(bus.cachedObjects());
+                changed = false;
+            }
+
+            const auto [busFd, busEvents] = bus.getPollFd();
+            pollfd fds[] = {{busFd, busEvents, 0}, {srv, POLLIN, 0}};
+            if (poll(fds, sizeof(fds) / sizeof(fds[0]), -1) == -1)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(),
+                                        "poll");
+            }
+
+            if (fds[1].revents & POLLIN)
+            {
+                const int conn = accept4(srv, nullptr, nullptr, SOCK_CLOEXEC);
+                if (conn != -1)
+                {
+                    bus.process();
+                    handleClient(bus, conn);
+                    close(conn);
+                }
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        fprintf(stderr, "%s\n", ex.what());
+    }
+
+    return EXIT_FAILURE;
+}
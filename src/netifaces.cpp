@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "netifaces.hpp"
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+NetIfaces& NetIfaces::instance()
+{
+    static NetIfaces netIfaces;
+    return netIfaces;
+}
+
+unsigned int NetIfaces::index(const std::string& name)
+{
+    // A single lookup is cheaper without the full dump
+    if (!loaded && ++lookups > 1)
+    {
+        loaded = load();
+    }
+
+    if (loaded)
+    {
+        const auto it = table.find(name);
+        if (it != table.end())
+        {
+            return it->second;
+        }
+    }
+
+    const unsigned int idx = if_nametoindex(name.c_str());
+    if (idx && loaded)
+    {
+        table.emplace(name, idx);
+    }
+    return idx;
+}
+
+void NetIfaces::reset()
+{
+    lookups = 0;
+    loaded = false;
+    table.clear();
+}
+
+bool NetIfaces::load()
+{
+    table.clear();
+
+    RtNetlink netlink;
+    const bool loaded = netlink.dump(RTM_GETLINK, [this](const nlmsghdr* hdr) {
+        if (hdr->nlmsg_type != RTM_NEWLINK)
+        {
+            return;
+        }
+        const auto* ifi = static_cast<const ifinfomsg*>(NLMSG_DATA(hdr));
+        size_t attrLen = IFLA_PAYLOAD(hdr);
+        for (const rtattr* rta = IFLA_RTA(ifi); RTA_OK(rta, attrLen);
+             rta = RTA_NEXT(rta, attrLen))
+        {
+            if (rta->rta_type == IFLA_IFNAME)
+            {
+                table.emplace(static_cast<const char*>(RTA_DATA(rta)),
+                              static_cast<unsigned int>(ifi->ifi_index));
+                break;
+            }
+        }
+    });
+
+    if (!loaded)
+    {
+        table.clear();
+    }
+    return loaded;
+}
+
+RtNetlink::RtNetlink() :
+    fd(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE))
+{}
+
+RtNetlink::~RtNetlink()
+{
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+bool RtNetlink::dump(uint16_t type, const Handler& handler)
+{
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    // All dump requests start with the address family, ifinfomsg is the
+    // largest of their headers
+    struct
+    {
+        nlmsghdr hdr;
+        ifinfomsg msg;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = sizeof(req);
+    req.hdr.nlmsg_type = type;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.hdr.nlmsg_seq = ++seq;
+    req.msg.ifi_family = AF_UNSPEC;
+
+    if (send(fd, &req, sizeof(req), 0) != sizeof(req))
+    {
+        return false;
+    }
+
+    alignas(nlmsghdr) char buf[16 * 1024];
+    while (true)
+    {
+        const ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len <= 0)
+        {
+            return false;
+        }
+
+        size_t remain = static_cast<size_t>(len);
+        for (const nlmsghdr* hdr = reinterpret_cast<const nlmsghdr*>(buf);
+             NLMSG_OK(hdr, remain); hdr = NLMSG_NEXT(hdr, remain))
+        {
+            if (hdr->nlmsg_seq != seq)
+            {
+                continue;
+            }
+            if (hdr->nlmsg_type == NLMSG_DONE)
+            {
+                return true;
+            }
+            if (hdr->nlmsg_type == NLMSG_ERROR)
+            {
+                return false;
+            }
+            handler(hdr);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <linux/netlink.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @class RtNetlink
+ * @brief Route netlink socket for dump requests (RTM_GETLINK, RTM_GETADDR,
+ *        etc). Several dumps can be done with the same socket.
+ */
+class RtNetlink
+{
+  public:
+    /** @brief Dumped message handler. */
+    using Handler = std::function<void(const nlmsghdr* hdr)>;
+
+    /** @brief Constructor: opens the socket. */
+    RtNetlink();
+
+    /** @brief Destructor: closes the socket. */
+    ~RtNetlink();
+
+    RtNetlink(const RtNetlink&) = delete;
+    RtNetlink& operator=(const RtNetlink&) = delete;
+
+    /**
+     * @brief Request the dump and pass every received message to the
+     *        handler.
+     *
+     * @param[in] type request type, e.g. RTM_GETLINK
+     * @param[in] handler message handler
+     *
+     * @return false if the socket can not be opened or the request failed
+     */
+    bool dump(uint16_t type, const Handler& handler);
+
+  private:
+    /** @brief Socket descriptor, -1 if not opened. */
+    int fd;
+    /** @brief Sequence number of the last request. */
+    uint32_t seq = 0;
+};
+
+/**
+ * @class NetIfaces
+ * @brief Cache of network interfaces known to the kernel.
+ *
+ * The first lookup is done with if_nametoindex(), further ones load the
+ * whole table with a single netlink RTM_GETLINK dump, so validation of
+ * many arguments (batch mode, daemon) costs O(1) per argument.
+ * Names missing in the table are checked with if_nametoindex() to catch
+ * interfaces created after the table was loaded (e.g. new VLANs).
+ * Long-living processes (daemon, shell) drop the table before every
+ * command, so removed interfaces are not reported as existing.
+ */
+class NetIfaces
+{
+  public:
+    /**
+     * @brief Get the process-wide instance.
+     *
+     * @return interfaces cache
+     */
+    static NetIfaces& instance();
+
+    /**
+     * @brief Get network interface index.
+     *
+     * @param[in] name network interface name
+     *
+     * @return interface index or 0 if interface doesn't exist
+     */
+    unsigned int index(const std::string& name);
+
+    /** @brief Drop the cache, the next lookup reloads it. */
+    void reset();
+
+  private:
+    NetIfaces() = default;
+
+    /**
+     * @brief Load the table with netlink RTM_GETLINK dump.
+     *
+     * @return false if netlink request failed
+     */
+    bool load();
+
+    /** @brief Number of lookups since the last reset. */
+    size_t lookups = 0;
+    /** @brief Flag: the table has been loaded. */
+    bool loaded = false;
+    /** @brief Interface name to index table. */
+    std::unordered_map<std::string, unsigned int> table;
+};
@@ -0,0 +1,882 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "networkd.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+/** @brief Extension of the network interface file. */
+static constexpr const char* networkExt = ".network";
+/** @brief Extension of the virtual device file. */
+static constexpr const char* netdevExt = ".netdev";
+
+/**
+ * @brief Remove leading and trailing white spaces.
+ *
+ * @param[in] str source string
+ *
+ * @return trimmed string
+ */
+static std::string trim(const std::string& str)
+{
+    static const char spaces[] = " \t\r";
+    const size_t begin = str.find_first_not_of(spaces);
+    if (begin == std::string::npos)
+    {
+        return std::string();
+    }
+    const size_t end = str.find_last_not_of(spaces);
+    return str.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief Read the whole file.
+ *
+ * @param[in] path path to the file
+ * @param[out] content file content
+ *
+ * @throw std::system_error in case of errors
+ *
+ * @return false if the file doesn't exist
+ */
+static bool readFile(const std::string& path, std::string& content)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        if (errno == ENOENT)
+        {
+            return false;
+        }
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    content.clear();
+    char buf[4096];
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) != 0)
+    {
+        if (len == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            const int err = errno;
+            close(fd);
+            throw std::system_error(err, std::generic_category(), path);
+        }
+        content.append(buf, len);
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief Flush the directory of the file to the disk, so the renamed or
+ *        removed entry survives a power loss.
+ *
+ * @param[in] path path to the file
+ *
+ * @throw std::system_error in case of errors
+ */
+static void syncDir(const std::string& path)
+{
+    const size_t slash = path.rfind('/');
+    const std::string dir =
+        slash == std::string::npos ? "." : path.substr(0, slash ? slash : 1);
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), dir);
+    }
+    const bool ok = fsync(fd) == 0;
+    const int err = errno;
+    close(fd);
+    if (!ok)
+    {
+        throw std::system_error(err, std::generic_category(), dir);
+    }
+}
+
+/**
+ * @brief Replace the file atomically: write a temporary file in the same
+ *        directory, flush it to the disk and rename over the target, then
+ *        flush the directory.
+ *
+ * @param[in] path path to the file
+ * @param[in] content file content
+ *
+ * @throw std::system_error in case of errors
+ */
+static void writeFile(const std::string& path, const std::string& content)
+{
+    std::string tmp = path + ".XXXXXX";
+    const int fd = mkostemp(tmp.data(), O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    bool ok = fchmod(fd, 0644) == 0;
+    size_t written = 0;
+    while (ok && written < content.size())
+    {
+        const ssize_t len =
+            write(fd, content.data() + written, content.size() - written);
+        if (len == -1)
+        {
+            ok = errno == EINTR;
+            continue;
+        }
+        written += len;
+    }
+    ok = ok && fsync(fd) == 0;
+    int err = errno;
+    if (close(fd) != 0 && ok)
+    {
+        ok = false;
+        err = errno;
+    }
+    if (ok && rename(tmp.c_str(), path.c_str()) == 0)
+    {
+        syncDir(path);
+        return;
+    }
+    if (ok)
+    {
+        err = errno;
+    }
+    unlink(tmp.c_str());
+    throw std::system_error(err, std::generic_category(), path);
+}
+
+/**
+ * @brief Remove the file and flush its directory.
+ *
+ * @param[in] path path to the file
+ *
+ * @throw std::system_error in case of errors
+ */
+static void removeFile(const std::string& path)
+{
+    if (unlink(path.c_str()) == 0)
+    {
+        syncDir(path);
+    }
+    else if (errno != ENOENT)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+}
+
+void UnitFile::parse(const std::string& text)
+{
+    sections.clear();
+    size_t lineNum = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos)
+        {
+            end = text.size();
+        }
+        const std::string line = trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        ++lineNum;
+
+        if (line.empty() || line[0] == '#' || line[0] == ';')
+        {
+            continue;
+        }
+        if (line[0] == '[' && line.back() == ']')
+        {
+            sections.push_back({line.substr(1, line.size() - 2), {}});
+            continue;
+        }
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos || sections.empty())
+        {
+            std::string err = "Malformed line ";
+            err += std::to_string(lineNum);
+            err += ": ";
+            err += line;
+            throw std::invalid_argument(err);
+        }
+        sections.back().entries.emplace_back(trim(line.substr(0, eq)),
+                                             trim(line.substr(eq + 1)));
+    }
+}
+
+std::string UnitFile::str() const
+{
+    std::string text;
+    for (const auto& section : sections)
+    {
+        if (!text.empty())
+        {
+            text += '\n';
+        }
+        text += '[';
+        text += section.name;
+        text += "]\n";
+        for (const auto& [key, value] : section.entries)
+        {
+            text += key;
+            text += '=';
+            text += value;
+            text += '\n';
+        }
+    }
+    return text;
+}
+
+bool UnitFile::load(const std::string& path)
+{
+    std::string text;
+    if (!readFile(path, text))
+    {
+        return false;
+    }
+    try
+    {
+        parse(text);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+    return true;
+}
+
+void UnitFile::save(const std::string& path) const
+{
+    writeFile(path, str());
+}
+
+std::optional<std::string> UnitFile::get(const char* section,
+                                         const char* key) const
+{
+    std::optional<std::string> value;
+    for (const auto& it : sections)
+    {
+        if (it.name != section)
+        {
+            continue;
+        }
+        for (const auto& [name, val] : it.entries)
+        {
+            if (name == key)
+            {
+                value = val;
+            }
+        }
+    }
+    return value;
+}
+
+std::vector<std::string> UnitFile::getList(const char* section,
+                                           const char* key) const
+{
+    std::vector<std::string> values;
+    for (const auto& it : sections)
+    {
+        if (it.name != section)
+        {
+            continue;
+        }
+        for (const auto& [name, val] : it.entries)
+        {
+            if (name != key)
+            {
+                continue;
+            }
+            if (val.empty())
+            {
+                values.clear();
+                continue;
+            }
+            size_t pos = 0;
+            while ((pos = val.find_first_not_of(" \t", pos)) !=
+                   std::string::npos)
+            {
+                const size_t end = val.find_first_of(" \t", pos);
+                values.emplace_back(val.substr(pos, end - pos));
+                pos = end;
+            }
+        }
+    }
+    return values;
+}
+
+void UnitFile::set(const char* section, const char* key,
+                   const std::vector<std::string>& values)
+{
+    Section* target = nullptr;
+    for (auto& it : sections)
+    {
+        if (it.name != section)
+        {
+            continue;
+        }
+        it.entries.erase(std::remove_if(it.entries.begin(), it.entries.end(),
+                                        [key](const Entry& entry) {
+                                            return entry.first == key;
+                                        }),
+                         it.entries.end());
+        if (!target)
+        {
+            target = &it;
+        }
+    }
+    if (!values.empty())
+    {
+        if (!target)
+        {
+            target = &sections.emplace_back(Section{section, {}});
+        }
+        for (const auto& value : values)
+        {
+            target->entries.emplace_back(key, value);
+        }
+    }
+    dropEmpty(section);
+}
+
+void UnitFile::addSection(const char* section, const char* key,
+                          const std::string& value)
+{
+    sections.push_back({section, {{key, value}}});
+}
+
+size_t UnitFile::remove(const char* section, const char* key,
+                        const std::string& value)
+{
+    size_t removed = 0;
+    for (auto& it : sections)
+    {
+        if (it.name != section)
+        {
+            continue;
+        }
+        const auto end = std::remove_if(
+            it.entries.begin(), it.entries.end(), [&](const Entry& entry) {
+                return entry.first == key && entry.second == value;
+            });
+        removed += it.entries.end() - end;
+        it.entries.erase(end, it.entries.end());
+    }
+    dropEmpty(section);
+    return removed;
+}
+
+void UnitFile::dropEmpty(const char* section)
+{
+    sections.erase(std::remove_if(sections.begin(), sections.end(),
+                                  [section](const Section& it) {
+                                      return it.name == section &&
+                                             it.entries.empty();
+                                  }),
+                   sections.end());
+}
+
+/**
+ * @struct StaticAddress
+ * @brief Static address entry of the network file.
+ */
+struct StaticAddress
+{
+    /** @brief Section holding the entry: Network or Address. */
+    const char* section;
+    /** @brief Entry value as written in the file. */
+    std::string entry;
+    /** @brief IP address. */
+    IpAddr address;
+    /** @brief Mask bits. */
+    uint8_t mask;
+};
+
+/**
+ * @brief Get static addresses from the network file: Address entries of
+ *        [Network] and [Address] sections. Malformed entries are skipped.
+ *
+ * @param[in] file network file
+ *
+ * @return addresses
+ */
+static std::vector<StaticAddress> readAddresses(const UnitFile& file)
+{
+    std::vector<StaticAddress> addresses;
+    for (const char* section : {"Network", "Address"})
+    {
+        for (const auto& entry : file.getList(section, "Address"))
+        {
+            const size_t slash = entry.find('/');
+            const auto addr = IpAddr::parse(entry.substr(0, slash).c_str());
+            if (!addr)
+            {
+                continue;
+            }
+            const uint8_t maxMask = addr->version() == IpVer::v4 ? 32 : 128;
+            unsigned long mask = maxMask;
+            if (slash != std::string::npos)
+            {
+                char* end;
+                mask = strtoul(entry.c_str() + slash + 1, &end, 10);
+                if (*end || mask > maxMask)
+                {
+                    continue;
+                }
+            }
+            addresses.push_back(
+                {section, entry, *addr, static_cast<uint8_t>(mask)});
+        }
+    }
+    return addresses;
+}
+
+/**
+ * @brief Check if the address belongs to the subnet.
+ *
+ * @param[in] addr IP address to check
+ * @param[in] net any address of the subnet
+ * @param[in] mask subnet mask bits
+ *
+ * @return true if the address belongs to the subnet
+ */
+static bool inSubnet(const IpAddr& addr, const IpAddr& net, uint8_t mask)
+{
+    if (addr.version() != net.version())
+    {
+        return false;
+    }
+    const uint8_t* a = addr.data();
+    const uint8_t* n = net.data();
+    const size_t bytes = mask / 8;
+    if (memcmp(a, n, bytes) != 0)
+    {
+        return false;
+    }
+    const uint8_t bits = mask % 8;
+    return !bits || ((a[bytes] ^ n[bytes]) >> (8 - bits)) == 0;
+}
+
+/**
+ * @brief Convert DHCP setting of the network file to the D-Bus value.
+ *
+ * @param[in] value DHCP setting, nothing if not set
+ *
+ * @return value of the DHCPEnabled property
+ */
+static std::string dhcpConf(const std::optional<std::string>& value)
+{
+    const char* conf = "none";
+    if (value)
+    {
+        if (*value == "true" || *value == "yes" || *value == "both")
+        {
+            conf = "both";
+        }
+        else if (*value == "ipv4")
+        {
+            conf = "v4";
+        }
+        else if (*value == "ipv6")
+        {
+            conf = "v6";
+        }
+    }
+    return std::string(
+               "xyz.openbmc_project.Network.EthernetInterface.DHCPConf.") +
+           conf;
+}
+
+/**
+ * @brief Parse boolean setting of the network file.
+ *
+ * @param[in] value setting value
+ *
+ * @return setting value
+ */
+static bool parseBool(const std::string& value)
+{
+    return value == "true" || value == "yes" || value == "on" || value == "1";
+}
+
+Networkd::Networkd(const char* dir, const char* hostnameFile) :
+    dir(dir), hostnameFile(hostnameFile)
+{}
+
+std::string Networkd::filePath(const std::string& name, const char* ext) const
+{
+    return dir + '/' + filePrefix + name + ext;
+}
+
+std::vector<std::string> Networkd::listNetworks() const
+{
+    std::vector<std::string> names;
+    DIR* dp = opendir(dir.c_str());
+    if (!dp)
+    {
+        if (errno == ENOENT)
+        {
+            return names;
+        }
+        throw std::system_error(errno, std::generic_category(), dir);
+    }
+    const size_t prefixLen = strlen(filePrefix);
+    const size_t extLen = strlen(networkExt);
+    while (const dirent* de = readdir(dp))
+    {
+        const std::string file = de->d_name;
+        if (file.size() > prefixLen + extLen &&
+            file.compare(0, prefixLen, filePrefix) == 0 &&
+            file.compare(file.size() - extLen, extLen, networkExt) == 0)
+        {
+            names.push_back(
+                file.substr(prefixLen, file.size() - prefixLen - extLen));
+        }
+    }
+    closedir(dp);
+    return names;
+}
+
+UnitFile Networkd::loadNetwork(const char* iface) const
+{
+    UnitFile file;
+    if (!file.load(filePath(iface, networkExt)))
+    {
+        std::string err = "Network interface ";
+        err += iface;
+        err += " is not configured in ";
+        err += dir;
+        throw std::invalid_argument(err);
+    }
+    return file;
+}
+
+Dbus::ManagedObject Networkd::getObjects() const
+{
+    Dbus::ManagedObject objects;
+
+    std::string hostname;
+    if (readFile(hostnameFile, hostname))
+    {
+        hostname = trim(hostname.substr(0, hostname.find('\n')));
+        objects[Dbus::objectConfig][Dbus::syscfgInterface]
+               [Dbus::syscfgHostname] = hostname;
+    }
+
+    std::vector<std::string> names = listNetworks();
+    // The default interface comes first, so its gateways win
+    std::sort(names.begin(), names.end(),
+              [](const std::string& a, const std::string& b) {
+                  const bool aDef = a == Dbus::defaultEth;
+                  const bool bDef = b == Dbus::defaultEth;
+                  return aDef != bDef ? aDef : a < b;
+              });
+
+    for (const auto& fileName : names)
+    {
+        UnitFile file;
+        if (!file.load(filePath(fileName, networkExt)))
+        {
+            continue;
+        }
+        const std::string name = file.get("Match", "Name").value_or(fileName);
+        const std::string path = Dbus::ethToPath(name.c_str());
+
+        auto& object = objects[path];
+        auto& eth = object[Dbus::ethInterface];
+        eth[Dbus::ethName] = name;
+        eth[Dbus::ethDhcpEnabled] = dhcpConf(file.get("Network", "DHCP"));
+        // Only static servers are known until the DHCP lease is obtained
+        const auto dns = file.getList("Network", "DNS");
+        eth[Dbus::ethNameServers] = dns;
+        eth[Dbus::ethStNameServers] = dns;
+        eth[Dbus::ethNtpServers] = file.getList("Network", "NTP");
+        if (const auto mac = file.get("Link", "MACAddress"))
+        {
+            object[Dbus::macInterface][Dbus::macSet] = *mac;
+        }
+
+        UnitFile netdev;
+        if (netdev.load(filePath(fileName, netdevExt)) &&
+            netdev.get("NetDev", "Kind") == "vlan")
+        {
+            if (const auto id = netdev.get("VLAN", "Id"))
+            {
+                object[Dbus::vlanInterface][Dbus::vlanId] =
+                    static_cast<uint32_t>(strtoul(id->c_str(), nullptr, 10));
+            }
+        }
+
+        // Fixed width keeps the addresses in the order of the file
+        size_t addrCount = 0;
+        for (const auto& it : readAddresses(file))
+        {
+            char id[32];
+            snprintf(id, sizeof(id), "/%s/%04zx",
+                     it.address.version() == IpVer::v4 ? "ipv4" : "ipv6",
+                     addrCount++);
+            auto& ip = objects[path + id][Dbus::ipInterface];
+            ip[Dbus::ipAddress] = it.address.str();
+            ip[Dbus::ipPrefix] = it.mask;
+            ip[Dbus::ipGateway] = std::string();
+            ip[Dbus::ipOrigin] = std::string(Dbus::ipOriginStatic);
+        }
+
+        auto& syscfg = objects[Dbus::objectConfig][Dbus::syscfgInterface];
+        for (const char* section : {"Network", "Route"})
+        {
+            for (const auto& gw : file.getList(section, "Gateway"))
+            {
+                const auto addr = IpAddr::parse(gw.c_str());
+                if (addr)
+                {
+                    syscfg.emplace(addr->version() == IpVer::v4
+                                       ? Dbus::syscfgDefGw4
+                                       : Dbus::syscfgDefGw6,
+                                   gw);
+                }
+            }
+        }
+
+        if (name == Dbus::defaultEth)
+        {
+            auto& dhcp = objects[Dbus::objectDhcp][Dbus::dhcpInterface];
+            dhcp[Dbus::dhcpDnsEnabled] =
+                parseBool(file.get("DHCP", "UseDNS").value_or("true"));
+            dhcp[Dbus::dhcpNtpEnabled] =
+                parseBool(file.get("DHCP", "UseNTP").value_or("true"));
+        }
+    }
+
+    return objects;
+}
+
+void Networkd::setHostname(const std::string& name) const
+{
+    writeFile(hostnameFile, name + '\n');
+}
+
+void Networkd::setGateway(const IpAddr& gateway) const
+{
+    std::vector<std::pair<std::string, UnitFile>> changed;
+    bool reachable = false;
+
+    // All files are checked before anything is written
+    for (const auto& name : listNetworks())
+    {
+        const std::string path = filePath(name, networkExt);
+        UnitFile file;
+        if (!file.load(path))
+        {
+            continue;
+        }
+        const std::string before = file.str();
+
+        const auto addresses = readAddresses(file);
+        const bool local = std::any_of(
+            addresses.begin(), addresses.end(), [&](const StaticAddress& it) {
+                return inSubnet(gateway, it.address, it.mask);
+            });
+        reachable = reachable || local;
+
+        // Gateways of the other IP version are kept as is
+        std::vector<std::string> gateways;
+        for (const auto& gw : file.getList("Network", "Gateway"))
+        {
+            const auto addr = IpAddr::parse(gw.c_str());
+            if (!addr || addr->version() != gateway.version())
+            {
+                gateways.push_back(gw);
+            }
+        }
+        if (local)
+        {
+            gateways.push_back(gateway.str());
+        }
+        file.set("Network", "Gateway", gateways);
+        for (const auto& gw : file.getList("Route", "Gateway"))
+        {
+            const auto addr = IpAddr::parse(gw.c_str());
+            if (addr && addr->version() == gateway.version())
+            {
+                file.remove("Route", "Gateway", gw);
+            }
+        }
+
+        if (file.str() != before)
+        {
+            changed.emplace_back(path, std::move(file));
+        }
+    }
+
+    if (!reachable)
+    {
+        throw std::runtime_error("Unreachable gateway specified");
+    }
+    for (const auto& [path, file] : changed)
+    {
+        file.save(path);
+    }
+}
+
+std::vector<std::tuple<IpAddr, uint8_t>>
+    Networkd::getAddresses(const char* iface) const
+{
+    std::vector<std::tuple<IpAddr, uint8_t>> addresses;
+    for (const auto& it : readAddresses(loadNetwork(iface)))
+    {
+        addresses.emplace_back(it.address, it.mask);
+    }
+    return addresses;
+}
+
+void Networkd::editAddresses(
+    const char* iface, const std::vector<IpAddr>& remove,
+    const std::vector<std::tuple<IpAddr, uint8_t>>& add) const
+{
+    UnitFile file = loadNetwork(iface);
+    const auto current = readAddresses(file);
+    const auto find = [&current](const IpAddr& addr) {
+        return std::find_if(
+            current.begin(), current.end(),
+            [&addr](const StaticAddress& it) { return it.address == addr; });
+    };
+
+    for (const auto& addr : remove)
+    {
+        const auto it = find(addr);
+        if (it == current.end())
+        {
+            std::string err = "IP address ";
+            err += addr.str();
+            err += " not found";
+            throw std::invalid_argument(err);
+        }
+        file.remove(it->section, "Address", it->entry);
+    }
+    for (const auto& [addr, mask] : add)
+    {
+        const bool removed =
+            std::find(remove.begin(), remove.end(), addr) != remove.end();
+        if (!removed && find(addr) != current.end())
+        {
+            std::string err = "IP address ";
+            err += addr.str();
+            err += " already exists";
+            throw std::invalid_argument(err);
+        }
+        file.addSection("Address", "Address",
+                        addr.str() + '/' + std::to_string(mask));
+    }
+
+    file.save(filePath(iface, networkExt));
+}
+
+void Networkd::setDhcp(const char* iface, bool enable) const
+{
+    UnitFile file = loadNetwork(iface);
+    file.set("Network", "DHCP", {enable ? "true" : "false"});
+    file.save(filePath(iface, networkExt));
+}
+
+std::vector<std::string> Networkd::getServers(const char* iface,
+                                              const char* key) const
+{
+    return loadNetwork(iface).getList("Network", key);
+}
+
+void Networkd::setServers(const char* iface, const char* key,
+                          const std::vector<std::string>& servers) const
+{
+    UnitFile file = loadNetwork(iface);
+    file.set("Network", key, servers);
+    file.save(filePath(iface, networkExt));
+}
+
+size_t Networkd::addVlans(const char* iface,
+                          const std::vector<uint32_t>& ids) const
+{
+    UnitFile parent = loadNetwork(iface);
+    std::vector<std::string> vlans = parent.getList("Network", "VLAN");
+
+    // VLAN files are written before the parent refers to them
+    size_t added = 0;
+    for (const uint32_t id : ids)
+    {
+        const std::string name = std::string(iface) + '.' + std::to_string(id);
+        const std::string netdevPath = filePath(name, netdevExt);
+        if (access(netdevPath.c_str(), F_OK) == 0)
+        {
+            continue;
+        }
+
+        UnitFile network;
+        network.set("Match", "Name", {name});
+        network.set("Network", "DHCP", {"false"});
+        network.save(filePath(name, networkExt));
+
+        UnitFile netdev;
+        netdev.set("NetDev", "Name", {name});
+        netdev.set("NetDev", "Kind", {"vlan"});
+        netdev.set("VLAN", "Id", {std::to_string(id)});
+        netdev.save(netdevPath);
+
+        if (std::find(vlans.begin(), vlans.end(), name) == vlans.end())
+        {
+            vlans.push_back(name);
+        }
+        ++added;
+    }
+
+    if (added)
+    {
+        parent.set("Network", "VLAN", vlans);
+        parent.save(filePath(iface, networkExt));
+    }
+    return added;
+}
+
+size_t Networkd::removeVlans(const char* iface,
+                             const std::vector<uint32_t>& ids) const
+{
+    UnitFile parent = loadNetwork(iface);
+
+    std::vector<std::string> names;
+    for (const uint32_t id : ids)
+    {
+        std::string name = std::string(iface) + '.' + std::to_string(id);
+        const bool referred = parent.remove("Network", "VLAN", name) != 0;
+        if (referred ||
+            access(filePath(name, netdevExt).c_str(), F_OK) == 0)
+        {
+            names.emplace_back(std::move(name));
+        }
+    }
+    if (names.empty())
+    {
+        return 0;
+    }
+
+    // The parent stops referring to VLANs before their files are removed
+    parent.save(filePath(iface, networkExt));
+    for (const auto& name : names)
+    {
+        removeFile(filePath(name, netdevExt));
+        removeFile(filePath(name, networkExt));
+    }
+    return names.size();
+}
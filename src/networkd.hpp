@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+#include "ipaddr.hpp"
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * @class UnitFile
+ * @brief systemd-networkd configuration file: sections with key=value
+ *        entries in order of appearance. Sections with the same name (e.g.
+ *        several [Address]) are kept separately. Comments are not preserved,
+ *        the network service rewrites the files without them anyway.
+ */
+class UnitFile
+{
+  public:
+    /**
+     * @brief Parse the file content.
+     *
+     * @param[in] text file content
+     *
+     * @throw std::invalid_argument if the content is malformed
+     */
+    void parse(const std::string& text);
+
+    /**
+     * @brief Get the file content.
+     *
+     * @return file content
+     */
+    std::string str() const;
+
+    /**
+     * @brief Load the file.
+     *
+     * @param[in] path path to the file
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return false if the file doesn't exist
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Save the file atomically: the content is written into
+     *        a temporary file in the same directory, flushed to the disk and
+     *        renamed over the target, so readers see either the old or the
+     *        new file, never a partial one. The directory is flushed after
+     *        the rename, so the new file survives a power loss.
+     *
+     * @param[in] path path to the file
+     *
+     * @throw std::system_error in case of errors
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Get the last value of the key in all sections with the name.
+     *
+     * @param[in] section section name
+     * @param[in] key key name
+     *
+     * @return value or nothing if the key is not set
+     */
+    std::optional<std::string> get(const char* section, const char* key) const;
+
+    /**
+     * @brief Get list of values: all entries of the key in all sections with
+     *        the name, each entry may hold several space separated values.
+     *        An empty entry resets the list as networkd does.
+     *
+     * @param[in] section section name
+     * @param[in] key key name
+     *
+     * @return values
+     */
+    std::vector<std::string> getList(const char* section,
+                                     const char* key) const;
+
+    /**
+     * @brief Replace all entries of the key with the values, one entry per
+     *        value. Entries are written into the first section with the
+     *        name, the section is created if missing.
+     *
+     * @param[in] section section name
+     * @param[in] key key name
+     * @param[in] values new values, empty list removes the key
+     */
+    void set(const char* section, const char* key,
+             const std::vector<std::string>& values);
+
+    /**
+     * @brief Append a new section with a single entry, e.g. [Address].
+     *
+     * @param[in] section section name
+     * @param[in] key key name
+     * @param[in] value entry value
+     */
+    void addSection(const char* section, const char* key,
+                    const std::string& value);
+
+    /**
+     * @brief Remove entries of the key with the value from all sections with
+     *        the name. Sections left empty are removed as well.
+     *
+     * @param[in] section section name
+     * @param[in] key key name
+     * @param[in] value entry value
+     *
+     * @return number of removed entries
+     */
+    size_t remove(const char* section, const char* key,
+                  const std::string& value);
+
+  private:
+    /** @brief Key and value. */
+    using Entry = std::pair<std::string, std::string>;
+
+    /**
+     * @struct Section
+     * @brief Section name with its entries.
+     */
+    struct Section
+    {
+        /** @brief Section name. */
+        std::string name;
+        /** @brief Entries in order of appearance. */
+        std::vector<Entry> entries;
+    };
+
+    /**
+     * @brief Remove sections with the name that have no entries.
+     *
+     * @param[in] section section name
+     */
+    void dropEmpty(const char* section);
+
+    /** @brief Sections in order of appearance. */
+    std::vector<Section> sections;
+};
+
+/**
+ * @class Networkd
+ * @brief Offline configuration backend: reads and edits the files persisted
+ *        by the network service instead of calling it over D-Bus.
+ *
+ * The network service keeps the configuration of every interface in
+ * `00-bmc-IFACE.network` inside the systemd-networkd directory, a VLAN also
+ * has `00-bmc-IFACE.ID.netdev`. The files are read by the service on start,
+ * so the configuration staged here is applied at once without a reload
+ * cycle per setting. The host name is kept in /etc/hostname.
+ *
+ * Every edit rewrites each affected file at most once, see UnitFile::save().
+ */
+class Networkd
+{
+  public:
+    /** @brief Prefix of the files managed by the network service. */
+    static constexpr const char* filePrefix = "00-bmc-";
+    /** @brief Default path to the host name file. */
+    static constexpr const char* defaultHostnameFile = "/etc/hostname";
+
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] dir systemd-networkd configuration directory
+     * @param[in] hostnameFile path to the host name file
+     */
+    Networkd(const char* dir, const char* hostnameFile);
+
+    /**
+     * @brief Read the whole configuration in the same form as the network
+     *        service objects, so it can be rendered in the same way.
+     *        Runtime state (link, speed, dynamic addresses) is absent.
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return network objects
+     */
+    Dbus::ManagedObject getObjects() const;
+
+    /**
+     * @brief Set host name.
+     *
+     * @param[in] name host name
+     *
+     * @throw std::exception in case of errors
+     */
+    void setHostname(const std::string& name) const;
+
+    /**
+     * @brief Set default gateway. The gateway is written into the files of
+     *        interfaces with a static address in the same subnet and removed
+     *        from all others.
+     *
+     * @param[in] gateway gateway address
+     *
+     * @throw std::runtime_error if no interface can reach the gateway
+     * @throw std::exception in case of errors
+     */
+    void setGateway(const IpAddr& gateway) const;
+
+    /**
+     * @brief Get static addresses of the interface.
+     *
+     * @param[in] iface network interface name
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return addresses with their masks
+     */
+    std::vector<std::tuple<IpAddr, uint8_t>>
+        getAddresses(const char* iface) const;
+
+    /**
+     * @brief Remove and add static addresses of the interface. All
+     *        addresses are checked before the file is written.
+     *
+     * @param[in] iface network interface name
+     * @param[in] remove addresses to remove
+     * @param[in] add addresses to add with their masks
+     *
+     * @throw std::invalid_argument if the address to remove doesn't exist or
+     *                              the address to add already exists
+     * @throw std::exception in case of errors
+     */
+    void editAddresses(const char* iface, const std::vector<IpAddr>& remove,
+                       const std::vector<std::tuple<IpAddr, uint8_t>>& add)
+        const;
+
+    /**
+     * @brief Enable or disable DHCP client.
+     *
+     * @param[in] iface network interface name
+     * @param[in] enable true to enable DHCP for both IPv4 and IPv6
+     *
+     * @throw std::exception in case of errors
+     */
+    void setDhcp(const char* iface, bool enable) const;
+
+    /**
+     * @brief Get list of servers.
+     *
+     * @param[in] iface network interface name
+     * @param[in] key servers kind: DNS or NTP
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return servers
+     */
+    std::vector<std::string> getServers(const char* iface,
+                                        const char* key) const;
+
+    /**
+     * @brief Replace list of servers.
+     *
+     * @param[in] iface network interface name
+     * @param[in] key servers kind: DNS or NTP
+     * @param[in] servers new list of servers
+     *
+     * @throw std::exception in case of errors
+     */
+    void setServers(const char* iface, const char* key,
+                    const std::vector<std::string>& servers) const;
+
+    /**
+     * @brief Add VLANs, existing ones are skipped.
+     *
+     * @param[in] iface parent network interface name
+     * @param[in] ids VLAN IDs
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return number of added VLANs
+     */
+    size_t addVlans(const char* iface, const std::vector<uint32_t>& ids) const;
+
+    /**
+     * @brief Remove VLANs, nonexistent ones are skipped.
+     *
+     * @param[in] iface parent network interface name
+     * @param[in] ids VLAN IDs
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return number of removed VLANs
+     */
+    size_t removeVlans(const char* iface,
+                       const std::vector<uint32_t>& ids) const;
+
+    /**
+     * @brief Load the network file of the interface.
+     *
+     * @param[in] iface network interface name
+     *
+     * @throw std::invalid_argument if the interface is not configured
+     * @throw std::exception in case of errors
+     *
+     * @return parsed file
+     */
+    UnitFile loadNetwork(const char* iface) const;
+
+  private:
+    /**
+     * @brief Get path to the interface file.
+     *
+     * @param[in] name network interface name
+     * @param[in] ext file extension: .network or .netdev
+     *
+     * @return path to the file
+     */
+    std::string filePath(const std::string& name, const char* ext) const;
+
+    /**
+     * @brief Get names of the interfaces with network files.
+     *
+     * @throw std::system_error in case of errors
+     *
+     * @return interface names as used in the file names
+     */
+    std::vector<std::string> listNetworks() const;
+
+    /** @brief systemd-networkd configuration directory. */
+    std::string dir;
+    /** @brief Path to the host name file. */
+    std::string hostnameFile;
+};
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "objcache.hpp"
+
+#include <sdbusplus/exception.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+namespace rules = sdbusplus::bus::match::rules;
+
+ObjectCache::ObjectCache(sdbusplus::bus::bus& bus) : bus(bus)
+{
+    // Subscribe before loading the tree to not miss any changes
+    matches.emplace_back(
+        bus,
+        rules::interfacesAdded(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this](sdbusplus::message::message& msg) { interfacesAdded(msg); });
+    matches.emplace_back(
+        bus,
+        rules::interfacesRemoved(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this](sdbusplus::message::message& msg) { interfacesRemoved(msg); });
+    matches.emplace_back(
+        bus,
+        rules::type::signal() + rules::member("PropertiesChanged") +
+            rules::interface(Dbus::propertiesInterface) +
+            rules::path_namespace(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this](sdbusplus::message::message& msg) { propertiesChanged(msg); });
+    matches.emplace_back(
+        bus, rules::nameOwnerChanged() + rules::argN(0, Dbus::networkService),
+        [this](sdbusplus::message::message& msg) { ownerChanged(msg); });
+
+    try
+    {
+        reload();
+    }
+    catch (const sdbusplus::exception::SdBusError& ex)
+    {
+        // The network service may start later than us, the tree is loaded
+        // when it appears on the bus
+        if (strcmp(ex.name(), "org.freedesktop.DBus.Error.ServiceUnknown") &&
+            strcmp(ex.name(), "org.freedesktop.DBus.Error.NameHasNoOwner"))
+        {
+            throw;
+        }
+    }
+}
+
+const Dbus::ManagedObject& ObjectCache::objects() const
+{
+    return netObjects;
+}
+
+void ObjectCache::setObserver(Observer handler)
+{
+    observer = std::move(handler);
+}
+
+void ObjectCache::reload()
+{
+    Dbus::ManagedObject objects;
+    auto mcall =
+        bus.new_method_call(Dbus::networkService, Dbus::objectRoot,
+                            Dbus::objmgrInterface, Dbus::objmgrGet);
+    Stats::Call stat(Dbus::networkService, Dbus::objectRoot,
+                     Dbus::objmgrInterface, Dbus::objmgrGet);
+    bus.call(mcall).read(objects);
+    netObjects.swap(objects);
+}
+
+void ObjectCache::interfacesAdded(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    std::map<std::string, Dbus::Properties> interfaces;
+    msg.read(path, interfaces);
+
+    auto& object = netObjects[path];
+    for (auto& [name, properties] : interfaces)
+    {
+        object[name] = std::move(properties);
+    }
+
+    if (observer)
+    {
+        observer(path.str);
+    }
+}
+
+void ObjectCache::interfacesRemoved(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    std::vector<std::string> interfaces;
+    msg.read(path, interfaces);
+
+    const auto object = netObjects.find(path);
+    if (object != netObjects.end())
+    {
+        for (const auto& name : interfaces)
+        {
+            object->second.erase(name);
+        }
+        if (object->second.empty())
+        {
+            netObjects.erase(object);
+        }
+        if (observer)
+        {
+            observer(path.str);
+        }
+    }
+}
+
+void ObjectCache::propertiesChanged(sdbusplus::message::message& msg)
+{
+    std::string interface;
+    Dbus::Properties changed;
+    std::vector<std::string> invalidated;
+    msg.read(interface, changed, invalidated);
+
+    const auto object = netObjects.find(msg.get_path());
+    if (object == netObjects.end())
+    {
+        // Will be reported by InterfacesAdded
+        return;
+    }
+
+    auto& properties = object->second[interface];
+    for (auto& [name, value] : changed)
+    {
+        properties[name] = std::move(value);
+    }
+    for (const auto& name : invalidated)
+    {
+        properties.erase(name);
+    }
+
+    if (observer)
+    {
+        observer(msg.get_path());
+    }
+}
+
+void ObjectCache::ownerChanged(sdbusplus::message::message& msg)
+{
+    std::string name, oldOwner, newOwner;
+    msg.read(name, oldOwner, newOwner);
+
+    if (newOwner.empty())
+    {
+        // Network service has gone
+        netObjects.clear();
+    }
+    else
+    {
+        // Exceptions must not cross sd-bus: the mirror is left empty until
+        // the next restart of the service
+        try
+        {
+            reload();
+        }
+        catch (const std::exception& ex)
+        {
+            fprintf(stderr, "Unable to load network objects: %s\n",
+                    ex.what());
+            netObjects.clear();
+        }
+    }
+
+    if (observer)
+    {
+        observer(std::string());
+    }
+}
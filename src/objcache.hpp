@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+
+#include <sdbusplus/bus/match.hpp>
+
+#include <functional>
+
+/**
+ * @class ObjectCache
+ * @brief Mirror of the network objects tree.
+ *
+ * The tree is fetched once and then kept up to date by the signals from
+ * the network service: InterfacesAdded, InterfacesRemoved and
+ * PropertiesChanged. The signals are handled while processing the D-Bus
+ * connection events, so the owner has to do that regularly.
+ */
+class ObjectCache
+{
+  public:
+    /**
+     * @brief Change handler.
+     *
+     * @param[in] path path to the changed object, empty if the whole tree
+     *                 has been reloaded or dropped
+     */
+    using Observer = std::function<void(const std::string& path)>;
+
+    /**
+     * @brief Constructor: subscribes to signals and loads the tree.
+     *        If the network service is not on the bus yet, the mirror is
+     *        empty until the service appears.
+     *
+     * @param[in] bus D-Bus connection
+     *
+     * @throw std::exception in case of errors
+     */
+    ObjectCache(sdbusplus::bus::bus& bus);
+
+    /**
+     * @brief Get mirrored network objects.
+     *
+     * @return network objects
+     */
+    const Dbus::ManagedObject& objects() const;
+
+    /**
+     * @brief Set handler called after every change of the mirror.
+     *
+     * @param[in] handler change handler
+     */
+    void setObserver(Observer handler);
+
+  private:
+    /** @brief Load the whole tree with GetManagedObjects. */
+    void reload();
+
+    /** @brief InterfacesAdded signal handler. */
+    void interfacesAdded(sdbusplus::message::message& msg);
+
+    /** @brief InterfacesRemoved signal handler. */
+    void interfacesRemoved(sdbusplus::message::message& msg);
+
+    /** @brief PropertiesChanged signal handler. */
+    void propertiesChanged(sdbusplus::message::message& msg);
+
+    /** @brief NameOwnerChanged signal handler (network service restart). */
+    void ownerChanged(sdbusplus::message::message& msg);
+
+  private:
+    /** @brief D-Bus connection. */
+    sdbusplus::bus::bus& bus;
+    /** @brief Mirrored network objects. */
+    Dbus::ManagedObject netObjects;
+    /** @brief Signal subscriptions. */
+    std::vector<sdbusplus::bus::match::match> matches;
+    /** @brief Change handler. */
+    Observer observer;
+};
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "query.hpp"
+
+#include <sdbusplus/exception.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @struct Query::Field
+ * @brief Description of the field available for query.
+ */
+struct Query::Field
+{
+    /** @brief Field name in the selector. */
+    const char* name;
+    /** @brief D-Bus service name. */
+    const char* service;
+    /** @brief D-Bus object path, nullptr for network interface object. */
+    const char* object;
+    /** @brief D-Bus interface name. */
+    const char* interface;
+    /** @brief D-Bus property name, nullptr for list of IP addresses. */
+    const char* property;
+};
+
+// clang-format off
+/** @brief Global network configuration fields: `global.FIELD`. */
+static const Query::Field globalFields[] = {
+    {"hostname", Dbus::networkService, Dbus::objectConfig, Dbus::syscfgInterface, Dbus::syscfgHostname},
+    {"gateway", Dbus::networkService, Dbus::objectConfig, Dbus::syscfgInterface, Dbus::syscfgDefGw4},
+    {"gateway6", Dbus::networkService, Dbus::objectConfig, Dbus::syscfgInterface, Dbus::syscfgDefGw6},
+    {"dhcp-dns", Dbus::networkService, Dbus::objectDhcp, Dbus::dhcpInterface, Dbus::dhcpDnsEnabled},
+    {"dhcp-ntp", Dbus::networkService, Dbus::objectDhcp, Dbus::dhcpInterface, Dbus::dhcpNtpEnabled},
+};
+
+/** @brief Remote syslog server fields: `syslog.FIELD`. */
+static const Query::Field syslogFields[] = {
+    {"address", Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface, Dbus::syslogAddr},
+    {"port", Dbus::syslogService, Dbus::objectSyslog, Dbus::syslogInterface, Dbus::syslogPort},
+};
+
+/** @brief Network interface fields: `INTERFACE.FIELD`. */
+static const Query::Field ifaceFields[] = {
+    {"mac", Dbus::networkService, nullptr, Dbus::macInterface, Dbus::macSet},
+    {"link", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethLinkUp},
+    {"speed", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethSpeed},
+    {"dhcp", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethDhcpEnabled},
+    {"ip", Dbus::networkService, nullptr, Dbus::ipInterface, nullptr},
+    {"dns", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethNameServers},
+    {"dns.static", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethStNameServers},
+    {"ntp", Dbus::networkService, nullptr, Dbus::ethInterface, Dbus::ethNtpServers},
+    {"vlan", Dbus::networkService, nullptr, Dbus::vlanInterface, Dbus::vlanId},
+};
+// clang-format on
+
+const char* Query::help =
+    "Print a single configuration value, SELECTOR is one of "
+    "global.{hostname|gateway|gateway6|dhcp-dns|dhcp-ntp}, "
+    "INTERFACE.{mac|link|speed|dhcp|ip|dns|dns.static|ntp|vlan}, "
+    "syslog.{address|port}";
+
+/**
+ * @brief Search for the field description by its name.
+ *
+ * @param[in] fields array of field descriptions
+ * @param[in] name field name
+ *
+ * @return pointer to the field description or nullptr if not found
+ */
+template <size_t N>
+static const Query::Field* findField(const Query::Field (&fields)[N],
+                                     const char* name)
+{
+    for (const auto& it : fields)
+    {
+        if (strcmp(it.name, name) == 0)
+        {
+            return &it;
+        }
+    }
+    return nullptr;
+}
+
+Query::Query(const char* selector) : field(nullptr)
+{
+    static const char globalScope[] = "global.";
+    static const char syslogScope[] = "syslog.";
+
+    if (strncmp(selector, globalScope, sizeof(globalScope) - 1) == 0)
+    {
+        field = findField(globalFields, selector + sizeof(globalScope) - 1);
+    }
+    else if (strncmp(selector, syslogScope, sizeof(syslogScope) - 1) == 0)
+    {
+        field = findField(syslogFields, selector + sizeof(syslogScope) - 1);
+    }
+    else
+    {
+        // VLAN interface names contain a dot, so search for the field by
+        // the selector's suffix
+        const size_t len = strlen(selector);
+        for (const auto& it : ifaceFields)
+        {
+            const size_t nameLen = strlen(it.name);
+            if (len > nameLen + 1 && selector[len - nameLen - 1] == '.' &&
+                strcmp(selector + len - nameLen, it.name) == 0)
+            {
+                field = &it;
+                iface.assign(selector, len - nameLen - 1);
+                break;
+            }
+        }
+    }
+
+    if (!field)
+    {
+        std::string err = "Invalid selector: ";
+        err += selector;
+        throw std::invalid_argument(err);
+    }
+}
+
+/**
+ * @brief Print property value.
+ *
+ * @param[in] value property value
+ */
+static void printValue(const Dbus::PropertyValue& value)
+{
+    std::visit(
+        [](auto&& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                puts(arg ? "true" : "false");
+            }
+            else if constexpr (std::is_arithmetic<T>::value)
+            {
+                printf("%u\n", static_cast<unsigned int>(arg));
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                // Print D-Bus enumerations without the type name prefix
+                puts(Dbus::shortEnum(arg));
+            }
+            else if constexpr (std::is_same_v<T, std::vector<std::string>>)
+            {
+                for (const auto& it : arg)
+                {
+                    puts(it.c_str());
+                }
+            }
+            else
+            {
+                static_assert(T::value, "Unhandled value type");
+            }
+        },
+        value);
+}
+
+/**
+ * @brief Print list of IP addresses.
+ *
+ * @param[in] addresses addresses to print
+ */
+static void printAddresses(const std::vector<Dbus::IpAddress>& addresses)
+{
+    for (const auto& it : addresses)
+    {
+        char buf[IpAddr::maxTextLen + 1];
+        *it.address.format(buf) = 0;
+        printf("%s/%u\n", buf, it.mask);
+    }
+}
+
+void Query::print(Dbus& bus) const
+{
+    const std::string ethObject =
+        iface.empty() ? std::string() : Dbus::ethToPath(iface.c_str());
+    const char* object = field->object ? field->object : ethObject.c_str();
+
+    if (field->service == Dbus::networkService)
+    {
+        if (const auto snapshot = bus.readSnapshot())
+        {
+            print(*snapshot, object);
+            return;
+        }
+    }
+
+    try
+    {
+        if (field->property)
+        {
+            Dbus::PropertyValue value;
+            auto reply =
+                bus.call(field->service, object, Dbus::propertiesInterface,
+                         Dbus::propertiesGet, field->interface,
+                         field->property);
+            {
+                Stats::Timer timer(Stats::decode);
+                reply.read(value);
+            }
+            Stats::Timer timer(Stats::render);
+            printValue(value);
+        }
+        else
+        {
+            // IP addresses are separate objects, there is no way to get
+            // them without fetching the objects tree. Check that the
+            // interface exists first: otherwise the list would be empty.
+            bus.get<std::string>(Dbus::networkService, object,
+                                 Dbus::ethInterface, Dbus::ethName);
+            const auto addresses = bus.getAddresses(object);
+            Stats::Timer timer(Stats::render);
+            printAddresses(addresses);
+        }
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+        if (!iface.empty() &&
+            strstr(e.what(), "org.freedesktop.DBus.Error.UnknownObject"))
+        {
+            std::string err = "Network interface not found: ";
+            err += iface;
+            throw std::invalid_argument(err);
+        }
+        throw;
+    }
+}
+
+void Query::print(const Dbus::ManagedObject& objects, const char* object) const
+{
+    Stats::Timer timer(Stats::render);
+
+    const auto obj = objects.find(sdbusplus::message::object_path(object));
+    if (obj == objects.end())
+    {
+        std::string err;
+        if (iface.empty())
+        {
+            err = "Object not found: ";
+            err += object;
+            throw std::runtime_error(err);
+        }
+        err = "Network interface not found: ";
+        err += iface;
+        throw std::invalid_argument(err);
+    }
+
+    if (!field->property)
+    {
+        printAddresses(Dbus::getAddresses(object, objects));
+        return;
+    }
+
+    const auto props = obj->second.find(field->interface);
+    if (props != obj->second.end())
+    {
+        const auto value = props->second.find(field->property);
+        if (value != props->second.end())
+        {
+            printValue(value->second);
+            return;
+        }
+    }
+    std::string err = "Value not available: ";
+    err += field->name;
+    throw std::runtime_error(err);
+}
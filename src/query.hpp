@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+
+#include <string>
+
+/**
+ * @class Query
+ * @brief Selective query of a single configuration value.
+ *
+ * The selector is mapped to the cheapest D-Bus request: a single
+ * `Properties.Get` on the exact object, or a filtered objects tree fetch
+ * for values that are not properties of one object (IP addresses).
+ * Network service values are read from the netconfigd snapshot without
+ * any D-Bus request if the snapshot is available.
+ */
+class Query
+{
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] selector value selector, e.g. `eth0.dns.static`
+     *
+     * @throw std::invalid_argument if selector is invalid
+     */
+    Query(const char* selector);
+
+    /**
+     * @brief Query the value and print it, one line per list item.
+     *
+     * @param[in] bus D-Bus instance
+     *
+     * @throw std::exception in case of errors
+     */
+    void print(Dbus& bus) const;
+
+    /** @brief Help text with the list of supported selectors. */
+    static const char* help;
+
+    /** @brief Field description, see query.cpp. */
+    struct Field;
+
+  private:
+    /**
+     * @brief Print the value from the objects tree.
+     *
+     * @param[in] objects network objects
+     * @param[in] object path to the object holding the value
+     *
+     * @throw std::exception if the value not found
+     */
+    void print(const Dbus::ManagedObject& objects, const char* object) const;
+
+    /** @brief Queried field description. */
+    const Field* field;
+    /** @brief Network interface name, empty for global fields. */
+    std::string iface;
+};
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "shell.hpp"
+
+#include "batch.hpp"
+#include "dbus.hpp"
+#include "netconfig.hpp"
+#include "netifaces.hpp"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+/** @brief Shell prompt. */
+static constexpr const char* prompt = "netconfig> ";
+
+/** @brief Print list of the shell commands. */
+static void printShellHelp()
+{
+    printf("COMMANDS:\n");
+    printf("  ifconfig\tNetwork configuration commands\n");
+    printf("  \t\tCommand format: ifconfig SUBCOMMAND [OPTION...]\n");
+    printf("  syslog\tRemote syslog server commands\n");
+    printf("  \t\tCommand format: syslog SUBCOMMAND [OPTION...]\n");
+    printf("  help\t\tPrint this help or help for the command\n");
+    printf("  \t\tCommand format: help [COMMAND [SUBCOMMAND]]\n");
+    printf("  exit\t\tExit the shell\n");
+}
+
+/**
+ * @brief Execute single shell command.
+ *
+ * @param[in] bus D-Bus instance
+ * @param[in] words command line split into words
+ *
+ * @throw std::exception in case of errors
+ */
+static void executeLine(Dbus& bus, std::vector<std::string>& words)
+{
+    std::vector<char*> argv;
+    argv.reserve(words.size());
+    for (auto& word : words)
+    {
+        argv.push_back(word.data());
+    }
+
+    Arguments args(static_cast<int>(argv.size()), argv.data());
+    const char* cmd = args.asText();
+
+    // `help ifconfig ip` is the same as `ifconfig help ip`
+    bool helpRequested = !strcmp(cmd, "help");
+    if (helpRequested)
+    {
+        if (!args.peek())
+        {
+            printShellHelp();
+            return;
+        }
+        cmd = args.asText();
+    }
+
+    if (strcmp(cmd, ifcfg) && strcmp(cmd, sslg))
+    {
+        std::string err = "Invalid command: ";
+        err += cmd;
+        err += ", expected one of [ifconfig, syslog, help, exit]";
+        throw std::invalid_argument(err);
+    }
+
+    if (!helpRequested && args.peek() && !strcmp(args.peek(), "help"))
+    {
+        ++args;
+        helpRequested = true;
+    }
+    if (helpRequested || !args.peek())
+    {
+        if (!args.peek())
+        {
+            printf("Usage: %s COMMAND [OPTION...]\n", cmd);
+            printf("       %s help COMMAND\n\n", cmd);
+            printf("COMMANDS:\n");
+        }
+        help(CLIMode::cliMode, cmd, args);
+        return;
+    }
+
+    // Interfaces may have been added or removed since the last command
+    NetIfaces::instance().reset();
+    execute(bus, cmd, args);
+}
+
+void shell()
+{
+    Dbus bus;
+    bus.enableCache();
+
+    const bool interactive = isatty(STDIN_FILENO);
+
+    char* line = nullptr;
+    size_t lineSize = 0;
+    while (true)
+    {
+        if (interactive)
+        {
+            fputs(prompt, stdout);
+            fflush(stdout);
+        }
+        if (getline(&line, &lineSize, stdin) == -1)
+        {
+            if (interactive)
+            {
+                putchar('\n');
+            }
+            break;
+        }
+
+        std::vector<std::string> words = splitCommand(line);
+        if (words.empty() || words.front()[0] == '#')
+        {
+            continue;
+        }
+        if (words.front() == "exit" || words.front() == "quit")
+        {
+            break;
+        }
+
+        try
+        {
+            // Apply changes signaled since the previous command
+            bus.process();
+            executeLine(bus, words);
+        }
+        catch (const std::exception& ex)
+        {
+            printError(ex);
+        }
+        fflush(stdout);
+    }
+    free(line);
+}
@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+/**
+ * @brief Run interactive shell: read commands from stdin and execute them
+ *        one by one until `exit` or end of input.
+ *        All commands share the same D-Bus connection and the mirror of
+ *        network objects, which is kept up to date by D-Bus signals, so
+ *        a command costs a single D-Bus round trip instead of a process
+ *        start and full tree fetch.
+ *
+ * @throw std::exception if D-Bus connection can not be established
+ */
+void shell();
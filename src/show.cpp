@@ -3,37 +3,468 @@
 
 #include "show.hpp"
 
-Show::Show(Dbus& bus) : bus(bus)
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+Show::Show(Dbus& bus) :
+    bus(bus), netObjects(bus.getManagedObjects(
+                  {Dbus::syscfgInterface, Dbus::dhcpInterface,
+                   Dbus::ethInterface, Dbus::vlanInterface, Dbus::macInterface,
+                   Dbus::ipInterface}))
+{}
+
+Show::Show(Dbus& bus, Dbus::ManagedObject objects) :
+    bus(bus), netObjects(std::move(objects))
+{}
+
+void Show::print()
 {
-    bus.call(Dbus::networkService, Dbus::objectRoot, Dbus::objmgrInterface,
-             Dbus::objmgrGet)
-        .read(netObjects);
+    Stats::Timer timer(Stats::render);
+
+    printGlobal();
+
+    // Network interfaces
+    for (const auto& it : netObjects)
+    {
+        if (it.second.find(Dbus::ethInterface) != it.second.end())
+        {
+            printInterface(static_cast<std::string>(it.first).c_str());
+        }
+    }
 }
 
-void Show::print()
+/**
+ * @brief Write text to the terminal clearing the rest of every line.
+ *
+ * @param[in] text text to write
+ */
+static void writeLines(const std::string& text)
+{
+    size_t start = 0;
+    size_t end;
+    while ((end = text.find('\n', start)) != std::string::npos)
+    {
+        fwrite(text.data() + start, 1, end - start, stdout);
+        fputs("\033[K\n", stdout);
+        start = end + 1;
+    }
+}
+
+/**
+ * @brief Get terminal height.
+ *
+ * @return number of rows, max value if unknown
+ */
+static size_t terminalRows()
+{
+    winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row)
+    {
+        return ws.ws_row;
+    }
+    return std::numeric_limits<size_t>::max();
+}
+
+/**
+ * @brief Check if any of the changed objects belongs to the block: it is
+ *        the block object itself or its child (e.g. IP address).
+ *
+ * @param[in] changed paths to the changed objects
+ * @param[in] object path to the block object
+ *
+ * @return true if the block has to be rendered again
+ */
+static bool isAffected(const std::set<std::string>& changed,
+                       const std::string& object)
+{
+    // Paths are sorted, so all children follow the object itself
+    for (auto it = changed.lower_bound(object);
+         it != changed.end() && it->compare(0, object.size(), object) == 0;
+         ++it)
+    {
+        if (it->size() == object.size() || (*it)[object.size()] == '/')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Show::watch()
+{
+    static const char* header =
+        "Network configuration (updated on change, press Ctrl+C to exit)\n\n";
+    static constexpr size_t headerLines = 2;
+
+    const bool tty = isatty(STDOUT_FILENO);
+
+    std::set<std::string> changed;
+    bool reloaded = false;
+    bus.observeCache([&](const std::string& path) {
+        if (path.empty())
+        {
+            reloaded = true;
+        }
+        else
+        {
+            changed.insert(path);
+        }
+    });
+
+    std::vector<Block> blocks = render({}, changed);
+    if (tty)
+    {
+        fputs("\033[H\033[2J", stdout);
+    }
+    fputs(header, stdout);
+    for (const auto& it : blocks)
+    {
+        fputs(it.text.c_str(), stdout);
+    }
+    fflush(stdout);
+
+    while (true)
+    {
+        bus.wait(std::numeric_limits<uint64_t>::max());
+        if (!reloaded && changed.empty())
+        {
+            continue;
+        }
+
+        // Patch the local copy with the changed objects only
+        const Dbus::ManagedObject& cached = bus.cachedObjects();
+        std::vector<Block> current;
+        if (reloaded)
+        {
+            netObjects = cached;
+            current = render({}, changed);
+        }
+        else
+        {
+            for (const auto& path : changed)
+            {
+                const sdbusplus::message::object_path key(path);
+                const auto it = cached.find(key);
+                if (it == cached.end())
+                {
+                    netObjects.erase(key);
+                }
+                else
+                {
+                    netObjects.insert_or_assign(key, it->second);
+                }
+            }
+            current = render(blocks, changed);
+        }
+        changed.clear();
+
+        // Blocks list changes if interface appears or disappears
+        bool redrawAll =
+            reloaded || current.size() != blocks.size() ||
+            !std::equal(current.begin(), current.end(), blocks.begin(),
+                        [](const Block& a, const Block& b) {
+                            return a.object == b.object;
+                        });
+        reloaded = false;
+
+        size_t totalLines = headerLines;
+        for (const auto& it : current)
+        {
+            totalLines += it.lines;
+        }
+        if (tty && totalLines > terminalRows())
+        {
+            redrawAll = true;
+        }
+
+        if (!tty)
+        {
+            // Print only changed blocks as a log record
+            bool stamped = false;
+            for (size_t i = 0; i < current.size(); ++i)
+            {
+                if (!redrawAll && current[i].text == blocks[i].text)
+                {
+                    continue;
+                }
+                if (!stamped)
+                {
+                    const time_t now = time(nullptr);
+                    char stamp[32];
+                    strftime(stamp, sizeof(stamp), "%F %T", localtime(&now));
+                    printf("--- %s\n", stamp);
+                    stamped = true;
+                }
+                fputs(current[i].text.c_str(), stdout);
+            }
+        }
+        else if (redrawAll)
+        {
+            fputs("\033[H\033[2J", stdout);
+            fputs(header, stdout);
+            for (const auto& it : current)
+            {
+                fputs(it.text.c_str(), stdout);
+            }
+        }
+        else
+        {
+            // Rewrite changed blocks in place; if the block height has
+            // changed, everything below it is shifted and rewritten too
+            size_t row = headerLines + 1;
+            bool shifted = false;
+            for (size_t i = 0; i < current.size(); ++i)
+            {
+                const bool dirty = current[i].text != blocks[i].text;
+                if (shifted || dirty)
+                {
+                    printf("\033[%zuH", row);
+                    writeLines(current[i].text);
+                    shifted = shifted || current[i].lines != blocks[i].lines;
+                }
+                row += current[i].lines;
+            }
+            if (shifted)
+            {
+                fputs("\033[J", stdout);
+            }
+        }
+        fflush(stdout);
+
+        blocks.swap(current);
+    }
+}
+
+std::vector<Show::Block> Show::render(const std::vector<Block>& previous,
+                                      const std::set<std::string>& changed)
+{
+    std::vector<Block> blocks;
+
+    // Take the previous block if the object is not changed, otherwise
+    // render it again
+    const auto add = [&](std::string object) {
+        Block& block = blocks.emplace_back();
+        const auto prev = std::find_if(
+            previous.begin(), previous.end(),
+            [&object](const Block& b) { return b.object == object; });
+        if (prev != previous.end() && !isAffected(changed, object))
+        {
+            block = *prev;
+        }
+        else
+        {
+            block.object = std::move(object);
+            renderBlock(block);
+        }
+    };
+
+    add(Dbus::objectConfig);
+    for (const auto& it : netObjects)
+    {
+        if (it.second.find(Dbus::ethInterface) != it.second.end())
+        {
+            add(it.first.str);
+        }
+    }
+
+    return blocks;
+}
+
+void Show::renderBlock(Block& block)
+{
+    char* buf = nullptr;
+    size_t size = 0;
+    out = open_memstream(&buf, &size);
+    if (!out)
+    {
+        out = stdout;
+        throw std::runtime_error("Unable to allocate output buffer");
+    }
+    // Global block also covers DHCP object, its path is a child of config
+    if (block.object == Dbus::objectConfig)
+    {
+        printGlobal();
+    }
+    else
+    {
+        printInterface(block.object.c_str());
+    }
+    fclose(out);
+    out = stdout;
+    block.text.assign(buf, size);
+    free(buf);
+    block.lines = std::count(block.text.begin(), block.text.end(), '\n');
+}
+
+void Show::printGlobal()
 {
     // Global config
     const auto globalCfg =
         getProperties(Dbus::objectConfig, Dbus::syscfgInterface);
-    puts("Global network configuration:");
+    fputs("Global network configuration:\n", out);
     printProperty("Host name", Dbus::syscfgHostname, globalCfg);
     printProperty("Default IPv4 gateway", Dbus::syscfgDefGw4, globalCfg);
     printProperty("Default IPv6 gateway", Dbus::syscfgDefGw6, globalCfg);
 
     // DHCP config
     const auto dhcpCfg = getProperties(Dbus::objectDhcp, Dbus::dhcpInterface);
-    puts("Global DHCP configuration:");
+    fputs("Global DHCP configuration:\n", out);
     printProperty("DNS over DHCP", Dbus::dhcpDnsEnabled, dhcpCfg);
     printProperty("NTP over DHCP", Dbus::dhcpNtpEnabled, dhcpCfg);
+}
+
+void Show::printJson(bool lines)
+{
+    Stats::Timer timer(Stats::render);
+    JsonWriter json;
+
+    if (lines)
+    {
+        json.beginObject().key("type").string("global");
+        writeGlobal(json);
+        json.endObject().endLine();
+    }
+    else
+    {
+        json.beginObject().key("global").beginObject();
+        writeGlobal(json);
+        json.endObject().key("interfaces").beginArray();
+    }
 
-    // Network interfaces
     for (const auto& it : netObjects)
     {
         if (it.second.find(Dbus::ethInterface) != it.second.end())
         {
-            printInterface(static_cast<std::string>(it.first).c_str());
+            json.beginObject();
+            if (lines)
+            {
+                json.key("type").string("interface");
+            }
+            writeInterface(json, static_cast<std::string>(it.first).c_str());
+            json.endObject();
+            if (lines)
+            {
+                json.endLine();
+            }
         }
     }
+
+    if (!lines)
+    {
+        json.endArray().endObject().endLine();
+    }
+}
+
+void Show::writeGlobal(JsonWriter& json) const
+{
+    const auto& globalCfg =
+        getProperties(Dbus::objectConfig, Dbus::syscfgInterface);
+    writeProperty(json, "hostname", Dbus::syscfgHostname, globalCfg);
+    writeProperty(json, "gateway", Dbus::syscfgDefGw4, globalCfg);
+    writeProperty(json, "gateway6", Dbus::syscfgDefGw6, globalCfg);
+
+    const auto& dhcpCfg = getProperties(Dbus::objectDhcp, Dbus::dhcpInterface);
+    writeProperty(json, "dhcp-dns", Dbus::dhcpDnsEnabled, dhcpCfg);
+    writeProperty(json, "dhcp-ntp", Dbus::dhcpNtpEnabled, dhcpCfg);
+}
+
+void Show::writeInterface(JsonWriter& json, const char* obj) const
+{
+    const auto& cfgEth = getProperties(obj, Dbus::ethInterface);
+    const auto& cfgVlan = getProperties(obj, Dbus::vlanInterface);
+    const auto& cfgMac = getProperties(obj, Dbus::macInterface);
+
+    writeProperty(json, "name", Dbus::ethName, cfgEth);
+    writeProperty(json, "vlan", Dbus::vlanId, cfgVlan);
+    writeProperty(json, "mac", Dbus::macSet, cfgMac);
+    writeProperty(json, "link", Dbus::ethLinkUp, cfgEth);
+    writeProperty(json, "speed", Dbus::ethSpeed, cfgEth);
+
+    json.key("ip").beginArray();
+    for (const auto& it : Dbus::getAddresses(obj, netObjects))
+    {
+        char buf[IpAddr::maxTextLen];
+        const char* end = it.address.format(buf);
+        json.beginObject();
+        json.key("address").string(std::string_view(buf, end - buf));
+        json.key("prefix").number(it.mask);
+        json.key("gateway");
+        if (it.gateway.empty())
+        {
+            json.null();
+        }
+        else
+        {
+            json.string(it.gateway);
+        }
+        json.key("origin");
+        if (it.origin.empty())
+        {
+            json.null();
+        }
+        else
+        {
+            json.string(Dbus::shortEnum(it.origin));
+        }
+        json.endObject();
+    }
+    json.endArray();
+
+    writeProperty(json, "dhcp", Dbus::ethDhcpEnabled, cfgEth);
+    writeProperty(json, "dns", Dbus::ethNameServers, cfgEth);
+    writeProperty(json, "dns.static", Dbus::ethStNameServers, cfgEth);
+    writeProperty(json, "ntp", Dbus::ethNtpServers, cfgEth);
+}
+
+void Show::writeProperty(JsonWriter& json, const char* key, const char* name,
+                         const Dbus::Properties& properties)
+{
+    json.key(key);
+
+    const auto it = properties.find(name);
+    if (it == properties.end())
+    {
+        json.null();
+    }
+    else
+    {
+        writeValue(json, it->second);
+    }
+}
+
+void Show::writeValue(JsonWriter& json, const Dbus::PropertyValue& value)
+{
+    std::visit(
+        [&json](auto&& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                json.boolean(arg);
+            }
+            else if constexpr (std::is_arithmetic<T>::value)
+            {
+                json.number(arg);
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                json.string(Dbus::shortEnum(arg));
+            }
+            else if constexpr (std::is_same_v<T, std::vector<std::string>>)
+            {
+                json.strings(arg);
+            }
+            else
+            {
+                static_assert(T::value, "Unhandled value type");
+            }
+        },
+        value);
 }
 
 void Show::printInterface(const char* obj)
@@ -43,7 +474,8 @@ void Show::printInterface(const char* obj)
     const auto cfgMac = getProperties(obj, Dbus::macInterface);
 
     const Dbus::PropertyValue& nameProp = cfgEth.find(Dbus::ethName)->second;
-    printf("Ethernet interface %s:\n", std::get<std::string>(nameProp).c_str());
+    fprintf(out, "Ethernet interface %s:\n",
+            std::get<std::string>(nameProp).c_str());
 
     if (!cfgVlan.empty())
     {
@@ -54,9 +486,9 @@ void Show::printInterface(const char* obj)
                   std::make_pair("DOWN", "UP"));
     printProperty("Link speed", Dbus::ethSpeed, cfgEth);
 
-    for (const auto& it : bus.getAddresses(obj))
+    for (const auto& it : Dbus::getAddresses(obj, netObjects))
     {
-        std::string val = it.address;
+        std::string val = it.address.str();
         val += '/';
         val += std::to_string(it.mask);
         if (!it.gateway.empty())
@@ -171,8 +603,8 @@ void Show::printProperty(const char* name, const char* value) const
     static const int nameWidth = 20;
 
     const int nameLen = static_cast<int>(strlen(name));
-    printf("  %s: %*s%s\n", name, nameLen < nameWidth ? nameWidth - nameLen : 0,
-           "", value);
+    fprintf(out, "  %s: %*s%s\n", name,
+            nameLen < nameWidth ? nameWidth - nameLen : 0, "", value);
 }
 
 const Dbus::Properties& Show::getProperties(const char* obj,
@@ -4,6 +4,11 @@
 #pragma once
 
 #include "dbus.hpp"
+#include "json.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
 
 /**
  * @class Show
@@ -19,12 +24,119 @@ class Show
      */
     Show(Dbus& bus);
 
+    /**
+     * @brief Constructor: uses the specified objects instead of fetching
+     *        them from the network service.
+     *
+     * @param[in] bus D-Bus instance
+     * @param[in] objects network objects
+     */
+    Show(Dbus& bus, Dbus::ManagedObject objects);
+
     /**
      * @brief Print current network configuration.
      */
     void print();
 
+    /**
+     * @brief Print current network configuration in JSON format.
+     *        Member names are the same as `get` command selectors.
+     *
+     * @param[in] lines JSON Lines format: global configuration and every
+     *                  interface are separate records
+     */
+    void printJson(bool lines);
+
+    /**
+     * @brief Print current network configuration and keep it up to date:
+     *        the objects tree is fetched once, then patched by D-Bus signals,
+     *        only the changed blocks are redrawn. Never returns.
+     *
+     * @throw std::exception in case of errors
+     */
+    void watch();
+
+    /**
+     * @brief Write property value, D-Bus enumerations are written without
+     *        the type name prefix.
+     *
+     * @param[in] json JSON writer
+     * @param[in] value property value
+     */
+    static void writeValue(JsonWriter& json, const Dbus::PropertyValue& value);
+
   private:
+    /**
+     * @struct Block
+     * @brief Rendered block of the output: global configuration or single
+     *        network interface.
+     */
+    struct Block
+    {
+        /** @brief D-Bus object path the block describes. */
+        std::string object;
+        /** @brief Rendered text. */
+        std::string text;
+        /** @brief Number of lines in the text. */
+        size_t lines;
+    };
+
+    /**
+     * @brief Render blocks of the output. Blocks of the previous output
+     *        that are not affected by the changed objects are reused as is.
+     *
+     * @param[in] previous blocks of the previous output
+     * @param[in] changed paths to the changed objects
+     *
+     * @throw std::exception in case of errors
+     *
+     * @return rendered blocks
+     */
+    std::vector<Block> render(const std::vector<Block>& previous,
+                              const std::set<std::string>& changed);
+
+    /**
+     * @brief Render single block of the output.
+     *
+     * @param[out] block block to render, object path must be set
+     *
+     * @throw std::exception in case of errors
+     */
+    void renderBlock(Block& block);
+
+    /**
+     * @brief Print global network configuration.
+     */
+    void printGlobal();
+
+    /**
+     * @brief Write global configuration members.
+     *
+     * @param[in] json JSON writer
+     */
+    void writeGlobal(JsonWriter& json) const;
+
+    /**
+     * @brief Write network interface members.
+     *
+     * @param[in] json JSON writer
+     * @param[in] obj path to D-Bus network object
+     */
+    void writeInterface(JsonWriter& json, const char* obj) const;
+
+    /**
+     * @brief Write property as a member of JSON object, `null` if the
+     *        property doesn't exist.
+     *
+     * @param[in] json JSON writer
+     * @param[in] key member name
+     * @param[in] name property name
+     * @param[in] properties array of properties
+     */
+    static void writeProperty(JsonWriter& json, const char* key,
+                              const char* name,
+                              const Dbus::Properties& properties);
+
     /**
      * @brief Print network interface properties.
      *
@@ -108,4 +220,6 @@ class Show
     Dbus& bus;
     /** @brief Array of D-Bus network configuration objects. */
     Dbus::ManagedObject netObjects;
+    /** @brief Output stream. */
+    FILE* out = stdout;
 };
@@ -0,0 +1,487 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <system_error>
+
+/**
+ * @struct Snapshot::Header
+ * @brief Header of the snapshot file.
+ */
+struct Snapshot::Header
+{
+    /** @brief File signature. */
+    uint32_t magic;
+    /** @brief Layout version. */
+    uint16_t version;
+    /** @brief Header size, payload starts at payloadOffset. */
+    uint16_t headerSize;
+    /** @brief Sequence number, odd while the data is being updated. */
+    std::atomic<uint32_t> seq;
+    /** @brief PID of the publisher. */
+    uint32_t pid;
+    /** @brief Flags, see flagValid. */
+    uint32_t flags;
+    /** @brief Payload size. */
+    uint32_t size;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Sequence lock requires lock-free atomics");
+
+/** @brief File signature: "NCSS". */
+static constexpr uint32_t snapshotMagic = 0x5353434e;
+/** @brief Flag: the payload is up to date. */
+static constexpr uint32_t flagValid = 1;
+/** @brief Payload offset, a separate cache line from the header. */
+static constexpr size_t payloadOffset = 64;
+/** @brief Number of read attempts while the writer updates the data. */
+static constexpr int maxReadAttempts = 100;
+
+/**
+ * @brief Check that the file (or directory) can be trusted: it is owned by
+ *        root or by the current user and nobody else can write to it.
+ *
+ * @param[in] st file status
+ *
+ * @return true if the file is trusted
+ */
+static bool isTrusted(const struct stat& st)
+{
+    return (st.st_uid == 0 || st.st_uid == geteuid()) &&
+           !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+Snapshot::Snapshot(const char* path)
+{
+    static_assert(sizeof(Header) <= payloadOffset);
+
+    // The directory is normally created by systemd (RuntimeDirectory)
+    const std::string dir(path, std::max(strrchr(path, '/'), path) - path);
+    struct stat st;
+    if (!dir.empty())
+    {
+        if (mkdir(dir.c_str(), 0755) == -1 && errno != EEXIST)
+        {
+            throw std::system_error(errno, std::generic_category(), dir);
+        }
+        if (lstat(dir.c_str(), &st) == -1 || !S_ISDIR(st.st_mode) ||
+            !isTrusted(st))
+        {
+            throw std::system_error(EPERM, std::generic_category(), dir);
+        }
+    }
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    // The file could be left by someone else, readers would reject it
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_uid != geteuid() || fchmod(fd, 0644) == -1)
+    {
+        close(fd);
+        throw std::system_error(EPERM, std::generic_category(), path);
+    }
+    const size_t size = payloadOffset + capacity;
+    void* mem = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+    {
+        mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int err = errno;
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        throw std::system_error(err, std::generic_category(), path);
+    }
+
+    header = static_cast<Header*>(mem);
+    // Previous publisher may have died in the middle of write() leaving the
+    // sequence odd, write() expects it even
+    header->seq.store(header->seq.load(std::memory_order_relaxed) & ~1u,
+                      std::memory_order_relaxed);
+    // Snapshot left by the previous publisher may be stale
+    write(nullptr);
+    header->magic = snapshotMagic;
+    header->version = layoutVersion;
+    header->headerSize = sizeof(Header);
+}
+
+Snapshot::~Snapshot()
+{
+    invalidate();
+    munmap(header, payloadOffset + capacity);
+}
+
+void Snapshot::publish(const Dbus::ManagedObject& objects)
+{
+    if (objects.empty())
+    {
+        write(nullptr);
+        return;
+    }
+    encode(objects, buffer);
+    write(buffer.size() <= capacity ? &buffer : nullptr);
+}
+
+void Snapshot::invalidate()
+{
+    write(nullptr);
+}
+
+void Snapshot::write(const std::string* payload)
+{
+    const uint32_t seq = header->seq.load(std::memory_order_relaxed);
+    header->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header->pid = static_cast<uint32_t>(getpid());
+    if (payload)
+    {
+        memcpy(reinterpret_cast<char*>(header) + payloadOffset,
+               payload->data(), payload->size());
+        header->size = static_cast<uint32_t>(payload->size());
+        header->flags = flagValid;
+    }
+    else
+    {
+        header->size = 0;
+        header->flags = 0;
+    }
+
+    header->seq.store(seq + 2, std::memory_order_release);
+}
+
+std::optional<Dbus::ManagedObject> Snapshot::read(const char* path)
+{
+    const int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return std::nullopt;
+    }
+    // Forged file would feed wrong configuration to every reader
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && isTrusted(st) &&
+        static_cast<size_t>(st.st_size) >= payloadOffset)
+    {
+        mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        return std::nullopt;
+    }
+
+    const auto* hdr = static_cast<const Header*>(mem);
+    const char* data = static_cast<const char*>(mem) + payloadOffset;
+    const size_t maxSize = st.st_size - payloadOffset;
+
+    bool valid = false;
+    uint32_t pid = 0;
+    std::string payload;
+    if (hdr->magic == snapshotMagic && hdr->version == layoutVersion &&
+        hdr->headerSize == sizeof(Header))
+    {
+        for (int i = 0; i < maxReadAttempts; ++i)
+        {
+            const uint32_t seq = hdr->seq.load(std::memory_order_acquire);
+            if (seq & 1)
+            {
+                continue;
+            }
+            valid = hdr->flags & flagValid;
+            pid = hdr->pid;
+            const size_t size = hdr->size;
+            payload.assign(data, std::min(size, maxSize));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (hdr->seq.load(std::memory_order_relaxed) == seq)
+            {
+                valid = valid && size <= maxSize;
+                break;
+            }
+            valid = false;
+        }
+    }
+    munmap(mem, st.st_size);
+
+    // Publisher has crashed without marking the snapshot as stale
+    if (!valid || (kill(static_cast<pid_t>(pid), 0) == -1 && errno == ESRCH))
+    {
+        return std::nullopt;
+    }
+
+    Dbus::ManagedObject objects;
+    if (!decode(payload, objects))
+    {
+        return std::nullopt;
+    }
+    return objects;
+}
+
+/**
+ * @brief Append number to the encoded data.
+ *
+ * @param[out] data encoded data
+ * @param[in] value number to append
+ */
+template <typename T>
+static void putNumber(std::string& data, T value)
+{
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Append string to the encoded data: length and characters.
+ *
+ * @param[out] data encoded data
+ * @param[in] str string to append
+ */
+static void putString(std::string& data, std::string_view str)
+{
+    putNumber(data, static_cast<uint32_t>(str.size()));
+    data.append(str);
+}
+
+void Snapshot::encode(const Dbus::ManagedObject& objects, std::string& data)
+{
+    static_assert(std::variant_size_v<Dbus::PropertyValue> == 6,
+                  "Update encode() and decode() for the new value types");
+
+    data.clear();
+    putNumber(data, static_cast<uint32_t>(objects.size()));
+    for (const auto& [path, interfaces] : objects)
+    {
+        putString(data, path.str);
+        putNumber(data, static_cast<uint32_t>(interfaces.size()));
+        for (const auto& [interface, properties] : interfaces)
+        {
+            putString(data, interface);
+            putNumber(data, static_cast<uint32_t>(properties.size()));
+            for (const auto& [name, value] : properties)
+            {
+                putString(data, name);
+                putNumber(data, static_cast<uint8_t>(value.index()));
+                std::visit(
+                    [&data](auto&& arg) {
+                        using T = std::decay_t<decltype(arg)>;
+                        if constexpr (std::is_arithmetic<T>::value)
+                        {
+                            putNumber(data, arg);
+                        }
+                        else if constexpr (std::is_same_v<T, std::string>)
+                        {
+                            putString(data, arg);
+                        }
+                        else
+                        {
+                            putNumber(data, static_cast<uint32_t>(arg.size()));
+                            for (const auto& it : arg)
+                            {
+                                putString(data, it);
+                            }
+                        }
+                    },
+                    value);
+            }
+        }
+    }
+}
+
+/**
+ * @class Decoder
+ * @brief Bounds-checked reader of the encoded data.
+ */
+class Decoder
+{
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] data encoded data
+     */
+    explicit Decoder(std::string_view data) : data(data)
+    {}
+
+    /**
+     * @brief Read number.
+     *
+     * @param[out] value read number
+     *
+     * @return false if data is too short
+     */
+    template <typename T>
+    bool number(T& value)
+    {
+        if (data.size() < sizeof(T))
+        {
+            return false;
+        }
+        memcpy(&value, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief Read string.
+     *
+     * @param[out] str read string
+     *
+     * @return false if data is too short
+     */
+    bool string(std::string& str)
+    {
+        uint32_t len;
+        if (!number(len) || data.size() < len)
+        {
+            return false;
+        }
+        str.assign(data.data(), len);
+        data.remove_prefix(len);
+        return true;
+    }
+
+    /**
+     * @brief Read number of items, each item takes at least `minItemSize`
+     *        bytes, so the damaged count is detected before allocating.
+     *
+     * @param[out] count number of items
+     * @param[in] minItemSize min size of the encoded item
+     *
+     * @return false if data is too short
+     */
+    bool count(uint32_t& count, size_t minItemSize)
+    {
+        return number(count) && data.size() / minItemSize >= count;
+    }
+
+    /**
+     * @brief Check that all data has been read.
+     *
+     * @return true if nothing left
+     */
+    bool empty() const
+    {
+        return data.empty();
+    }
+
+  private:
+    /** @brief Data left to read. */
+    std::string_view data;
+};
+
+/**
+ * @brief Decode property value.
+ *
+ * @param[in] dec decoder
+ * @param[out] value property value
+ *
+ * @return false if data is malformed
+ */
+static bool decodeValue(Decoder& dec, Dbus::PropertyValue& value)
+{
+    uint8_t type;
+    if (!dec.number(type))
+    {
+        return false;
+    }
+    switch (type)
+    {
+        case 0:
+            return dec.number(value.emplace<uint8_t>());
+        case 1:
+            return dec.number(value.emplace<uint16_t>());
+        case 2:
+            return dec.number(value.emplace<uint32_t>());
+        case 3:
+        {
+            uint8_t flag;
+            if (!dec.number(flag))
+            {
+                return false;
+            }
+            value = flag != 0;
+            return true;
+        }
+        case 4:
+            return dec.string(value.emplace<std::string>());
+        case 5:
+        {
+            auto& list = value.emplace<std::vector<std::string>>();
+            uint32_t count;
+            if (!dec.count(count, sizeof(uint32_t)))
+            {
+                return false;
+            }
+            list.resize(count);
+            for (auto& it : list)
+            {
+                if (!dec.string(it))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Snapshot::decode(std::string_view data, Dbus::ManagedObject& objects)
+{
+    // Min sizes of encoded items: name length and items count
+    static constexpr size_t minObject = 2 * sizeof(uint32_t);
+    static constexpr size_t minProperty = sizeof(uint32_t) + 2;
+
+    Decoder dec(data);
+    objects.clear();
+
+    uint32_t objectsCount;
+    if (!dec.count(objectsCount, minObject))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < objectsCount; ++i)
+    {
+        std::string path;
+        uint32_t interfacesCount;
+        if (!dec.string(path) || !dec.count(interfacesCount, minObject))
+        {
+            return false;
+        }
+        auto& interfaces = objects[sdbusplus::message::object_path(path)];
+        for (uint32_t j = 0; j < interfacesCount; ++j)
+        {
+            std::string interface;
+            uint32_t propertiesCount;
+            if (!dec.string(interface) ||
+                !dec.count(propertiesCount, minProperty))
+            {
+                return false;
+            }
+            auto& properties = interfaces[interface];
+            for (uint32_t k = 0; k < propertiesCount; ++k)
+            {
+                std::string name;
+                if (!dec.string(name) || !decodeValue(dec, properties[name]))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return dec.empty();
+}
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "dbus.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @class Snapshot
+ * @brief Network objects tree published in shared memory.
+ *
+ * netconfigd publishes its objects mirror into a file in a tmpfs directory
+ * owned by root (/run/netconfig), read commands map the file and copy the
+ * tree out without any D-Bus traffic. Readers accept only a regular file
+ * owned by root (or by themselves) that nobody else can write to, so
+ * a local user can't feed them a forged tree.
+ * The file is updated in place under a sequence lock: the sequence number
+ * is odd while the writer updates the data, readers retry if it was odd or
+ * has changed while they were copying. Readers never take any lock and
+ * never block the writer.
+ *
+ * The file holds a fixed header (magic, layout version, sequence number,
+ * publisher PID, flags, payload size) followed by the encoded tree in the
+ * native byte order: the file never leaves the host. Readers reject
+ * unknown layout versions, so an old reader falls back to D-Bus instead of
+ * misreading a newer layout.
+ */
+class Snapshot
+{
+  public:
+    /** @brief Layout version, must be incremented on any layout change. */
+    static constexpr uint16_t layoutVersion = 1;
+    /** @brief Max size of the encoded tree. */
+    static constexpr size_t capacity = 1024 * 1024;
+
+    /**
+     * @brief Constructor: creates the file and maps it for writing.
+     *        The snapshot is stale until the first publish(). Symbolic
+     *        links, files of other users and directories writable by
+     *        others are refused.
+     *
+     * @param[in] path path to the snapshot file
+     *
+     * @throw std::system_error in case of errors
+     */
+    explicit Snapshot(const char* path);
+
+    /** @brief Destructor: marks the snapshot as stale. */
+    ~Snapshot();
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /**
+     * @brief Publish the objects tree. Empty tree means the network service
+     *        is not running, so it marks the snapshot as stale, as well as
+     *        a tree that doesn't fit the capacity.
+     *
+     * @param[in] objects network objects
+     */
+    void publish(const Dbus::ManagedObject& objects);
+
+    /** @brief Mark the snapshot as stale, readers will use D-Bus. */
+    void invalidate();
+
+    /**
+     * @brief Read the snapshot.
+     *
+     * @param[in] path path to the snapshot file
+     *
+     * @return network objects or nothing if the snapshot is missing, stale
+     *         (publisher has gone), has unknown layout or is damaged
+     */
+    static std::optional<Dbus::ManagedObject> read(const char* path);
+
+    /**
+     * @brief Encode the objects tree.
+     *
+     * @param[in] objects network objects
+     * @param[out] data encoded tree
+     */
+    static void encode(const Dbus::ManagedObject& objects, std::string& data);
+
+    /**
+     * @brief Decode the objects tree.
+     *
+     * @param[in] data encoded tree
+     * @param[out] objects network objects
+     *
+     * @return false if data is malformed
+     */
+    static bool decode(std::string_view data, Dbus::ManagedObject& objects);
+
+  private:
+    struct Header;
+
+    /**
+     * @brief Update the mapped file under the sequence lock.
+     *
+     * @param[in] payload encoded tree, nullptr to mark the snapshot as stale
+     */
+    void write(const std::string* payload);
+
+    /** @brief Mapped file. */
+    Header* header;
+    /** @brief Encoding buffer, reused between publications. */
+    std::string buffer;
+};
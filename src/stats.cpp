@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "stats.hpp"
+
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+using Clock = std::chrono::steady_clock;
+using Duration = std::chrono::duration<double, std::milli>;
+
+/**
+ * @struct State
+ * @brief Collected statistics.
+ */
+struct State
+{
+    /** @brief Collecting is enabled. */
+    bool enabled = false;
+    /** @brief Printing of D-Bus calls is enabled. */
+    bool trace = false;
+    /** @brief Start time. */
+    Clock::time_point start;
+    /** @brief Time spent in each phase. */
+    Duration phases[Stats::phasesCount] = {};
+    /** @brief Number of D-Bus method calls. */
+    size_t calls = 0;
+    /** @brief Number of failed D-Bus method calls. */
+    size_t errors = 0;
+    /** @brief Bytes read/written by the process at start. */
+    size_t readBytes = 0;
+    size_t writtenBytes = 0;
+};
+
+static State state;
+
+/**
+ * @brief Get number of bytes read/written by the process.
+ *        Only read() and write() family calls are counted, D-Bus messages
+ *        are sent and received with sendmsg() and recvmsg(), so they are
+ *        not included.
+ *
+ * @param[out] read number of read bytes
+ * @param[out] written number of written bytes
+ */
+static void getIoCounters(size_t& read, size_t& written)
+{
+    FILE* io = fopen("/proc/self/io", "r");
+    if (io)
+    {
+        char line[64];
+        while (fgets(line, sizeof(line), io))
+        {
+            sscanf(line, "rchar: %zu", &read);
+            sscanf(line, "wchar: %zu", &written);
+        }
+        fclose(io);
+    }
+}
+
+void Stats::enable(bool trace)
+{
+    state.enabled = true;
+    state.trace = trace;
+    state.start = Clock::now();
+    getIoCounters(state.readBytes, state.writtenBytes);
+}
+
+bool Stats::enabled()
+{
+    return state.enabled;
+}
+
+void Stats::report()
+{
+    if (!state.enabled)
+    {
+        return;
+    }
+
+    const Duration total = Clock::now() - state.start;
+    Duration other = total;
+    for (const auto& phase : state.phases)
+    {
+        other -= phase;
+    }
+
+    size_t readBytes = 0;
+    size_t writtenBytes = 0;
+    getIoCounters(readBytes, writtenBytes);
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "Statistics:\n");
+    fprintf(stderr, "  Total time:           %.3f ms\n", total.count());
+    fprintf(stderr, "  Bus connect:          %.3f ms\n",
+            state.phases[connect].count());
+    fprintf(stderr, "  D-Bus calls:          %.3f ms (%zu calls, %zu failed)\n",
+            state.phases[call].count(), state.calls, state.errors);
+    fprintf(stderr, "  Decoding:             %.3f ms\n",
+            state.phases[decode].count());
+    fprintf(stderr, "  Rendering:            %.3f ms\n",
+            state.phases[render].count());
+    fprintf(stderr, "  Parsing and other:    %.3f ms\n", other.count());
+    fprintf(stderr,
+            "  I/O bytes:            %zu read, %zu written (excluding D-Bus)\n",
+            readBytes - state.readBytes, writtenBytes - state.writtenBytes);
+    fprintf(stderr, "  CPU time:             %.3f ms user, %.3f ms system\n",
+            usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3,
+            usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3);
+    fprintf(stderr, "  Max RSS:              %ld KiB\n", usage.ru_maxrss);
+    fprintf(stderr, "  Context switches:     %ld voluntary, %ld involuntary\n",
+            usage.ru_nvcsw, usage.ru_nivcsw);
+}
+
+Stats::Timer::Timer(Phase phase) : phase(phase)
+{
+    if (state.enabled)
+    {
+        start = Clock::now();
+    }
+}
+
+Stats::Timer::~Timer()
+{
+    if (state.enabled)
+    {
+        state.phases[phase] += Clock::now() - start;
+    }
+}
+
+Stats::Call::Call(const char* service, const char* object,
+                  const char* interface, const char* name, bool async) :
+    service(service),
+    object(object), interface(interface), name(name), async(async)
+{
+    if (state.enabled)
+    {
+        start = Clock::now();
+    }
+}
+
+Stats::Call::~Call()
+{
+    if (state.enabled)
+    {
+        const Duration duration = Clock::now() - start;
+        const bool error = failed || std::uncaught_exceptions() != 0;
+        if (!async)
+        {
+            state.phases[call] += duration;
+        }
+        ++state.calls;
+        if (error)
+        {
+            ++state.errors;
+        }
+        if (state.trace)
+        {
+            fprintf(stderr, "trace: %8.3f ms %s %s %s.%s%s\n",
+                    duration.count(), service, object, interface, name,
+                    error ? " (failed)" : "");
+        }
+    }
+}
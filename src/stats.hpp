@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <chrono>
+
+/**
+ * @class Stats
+ * @brief Execution statistics: time spent in different phases, D-Bus calls
+ *        and resource usage. Collecting is disabled by default and costs
+ *        nothing but a flag check in this case.
+ */
+class Stats
+{
+  public:
+    /** @brief Execution phases. */
+    enum Phase
+    {
+        connect,
+        call,
+        decode,
+        render,
+        phasesCount
+    };
+
+    /**
+     * @brief Enable collecting.
+     *
+     * @param[in] trace print every D-Bus call to stderr
+     */
+    static void enable(bool trace);
+
+    /**
+     * @brief Check if collecting is enabled.
+     *
+     * @return true if collecting is enabled
+     */
+    static bool enabled();
+
+    /**
+     * @brief Print collected statistics to stderr.
+     */
+    static void report();
+
+    /**
+     * @class Timer
+     * @brief Accounts time of its life to the specified phase.
+     */
+    class Timer
+    {
+      public:
+        /**
+         * @brief Constructor.
+         *
+         * @param[in] phase execution phase
+         */
+        Timer(Phase phase);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+      private:
+        /** @brief Execution phase. */
+        Phase phase;
+        /** @brief Start time. */
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * @class Call
+     * @brief Accounts D-Bus method call round trip.
+     *
+     * Round trips of asynchronous calls overlap, so their durations are
+     * only printed in the trace. The time spent waiting for their replies
+     * is accounted to the call phase by the caller with a Timer.
+     */
+    class Call
+    {
+      public:
+        /**
+         * @brief Constructor.
+         *
+         * @param[in] service D-Bus service name
+         * @param[in] object D-Bus object path
+         * @param[in] interface interface name
+         * @param[in] name method name
+         * @param[in] async asynchronous call, its duration is not accounted
+         *                  to the call phase
+         */
+        Call(const char* service, const char* object, const char* interface,
+             const char* name, bool async = false);
+        ~Call();
+
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+
+        /** @brief Mark the call as failed (for calls completed without
+         *         throwing an exception). */
+        void fail()
+        {
+            failed = true;
+        }
+
+      private:
+        /** @brief Method description for the trace. */
+        const char* service;
+        const char* object;
+        const char* interface;
+        const char* name;
+        /** @brief Asynchronous call flag. */
+        bool async;
+        /** @brief Failure flag. */
+        bool failed = false;
+        /** @brief Start time. */
+        std::chrono::steady_clock::time_point start;
+    };
+};
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "waiter.hpp"
+
+#include <stdexcept>
+
+namespace rules = sdbusplus::bus::match::rules;
+
+Waiter::Waiter(Dbus& bus, Arguments& args) :
+    bus(bus), timeout(0), applied(false)
+{
+    const auto option = args.takeOption("--wait");
+    if (option)
+    {
+        size_t value = defaultTimeout;
+        if (!option->empty())
+        {
+            if (!Arguments::isNumber(option->c_str()) ||
+                !(value = strtoul(option->c_str(), nullptr, 10)))
+            {
+                std::string err = "Invalid timeout: ";
+                err += *option;
+                err += ", expected number of seconds";
+                throw std::invalid_argument(err);
+            }
+        }
+        timeout = std::chrono::seconds(value);
+    }
+}
+
+Waiter::operator bool() const
+{
+    return timeout.count() != 0;
+}
+
+void Waiter::expectChange(const std::string& object, const char* interface,
+                          Check check)
+{
+    if (!*this)
+    {
+        return;
+    }
+
+    matches.emplace_back(bus.subscribe(
+        rules::propertiesChanged(object, interface) +
+            rules::sender(Dbus::networkService),
+        [this, check](sdbusplus::message::message& msg) {
+            std::string iface;
+            Dbus::Properties changed;
+            msg.read(iface, changed);
+            applied = applied || check(changed);
+        }));
+    matches.emplace_back(bus.subscribe(
+        rules::interfacesAdded(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this, object, interface, check](sdbusplus::message::message& msg) {
+            interfacesAdded(msg, object, true, interface, check);
+        }));
+
+    // The property may already have the expected value, in this case
+    // the network service may not report any changes
+    try
+    {
+        applied = check(
+            bus.getAll(Dbus::networkService, object.c_str(), interface));
+    }
+    catch (const std::exception&)
+    {
+        // object doesn't exist yet
+    }
+
+    start = Clock::now();
+}
+
+void Waiter::expectObject(const std::string& prefix, const char* interface,
+                          Check check)
+{
+    if (!*this)
+    {
+        return;
+    }
+
+    matches.emplace_back(bus.subscribe(
+        rules::interfacesAdded(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this, prefix, interface, check](sdbusplus::message::message& msg) {
+            interfacesAdded(msg, prefix, false, interface, check);
+        }));
+
+    start = Clock::now();
+}
+
+void Waiter::expectRemoval(const std::string& object)
+{
+    if (!*this)
+    {
+        return;
+    }
+
+    matches.emplace_back(bus.subscribe(
+        rules::interfacesRemoved(Dbus::objectRoot) +
+            rules::sender(Dbus::networkService),
+        [this, object](sdbusplus::message::message& msg) {
+            sdbusplus::message::object_path path;
+            msg.read(path);
+            applied = applied || static_cast<std::string>(path) == object;
+        }));
+
+    start = Clock::now();
+}
+
+void Waiter::wait()
+{
+    if (!*this)
+    {
+        return;
+    }
+
+    bus.process();
+
+    const auto deadline = start + timeout;
+    while (!applied)
+    {
+        const auto now = Clock::now();
+        if (now >= deadline)
+        {
+            throw std::runtime_error(
+                "Timed out waiting for the change to be applied");
+        }
+        bus.wait(std::chrono::duration_cast<std::chrono::microseconds>(
+                     deadline - now)
+                     .count());
+    }
+
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                              start);
+    printf("Change has been applied in %lld ms\n",
+           static_cast<long long>(elapsed.count()));
+
+    matches.clear();
+}
+
+Waiter::Check Waiter::equals(const char* name,
+                             const Dbus::PropertyValue& value)
+{
+    return [name = std::string(name), value](const Dbus::Properties& props) {
+        const auto it = props.find(name);
+        return it != props.end() && it->second == value;
+    };
+}
+
+void Waiter::interfacesAdded(sdbusplus::message::message& msg,
+                             const std::string& prefix, bool exact,
+                             const char* interface, const Check& check)
+{
+    sdbusplus::message::object_path path;
+    std::map<std::string, Dbus::Properties> interfaces;
+    msg.read(path, interfaces);
+
+    const std::string& strPath = path;
+    const bool match = exact ? strPath == prefix
+                             : strPath.compare(0, prefix.length(), prefix) == 0;
+    if (match)
+    {
+        const auto it = interfaces.find(interface);
+        if (it != interfaces.end())
+        {
+            applied = applied || check(it->second);
+        }
+    }
+}
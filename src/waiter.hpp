@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include "arguments.hpp"
+#include "dbus.hpp"
+
+#include <chrono>
+#include <functional>
+
+/**
+ * @class Waiter
+ * @brief Waits until the network service applies the requested change.
+ *
+ * Expected changes must be registered before sending the request: that
+ * subscribes to the D-Bus signals, so the change is caught even if it is
+ * applied before the method call returns.
+ */
+class Waiter
+{
+  public:
+    /** @brief Default timeout in seconds. */
+    static constexpr size_t defaultTimeout = 30;
+
+    /**
+     * @brief Properties check function.
+     *
+     * @param[in] properties set of the changed properties
+     *
+     * @return true if the properties have expected values
+     */
+    using Check = std::function<bool(const Dbus::Properties& properties)>;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param[in] bus D-Bus instance
+     * @param[in] args command arguments, `--wait[=TIMEOUT]` option is
+     *                 extracted from them
+     *
+     * @throw std::invalid_argument if timeout value is invalid
+     */
+    Waiter(Dbus& bus, Arguments& args);
+
+    /**
+     * @brief Check if waiting was requested.
+     *
+     * @return true if waiting is enabled
+     */
+    explicit operator bool() const;
+
+    /**
+     * @brief Expect change of the properties: PropertiesChanged signal or
+     *        (re)creation of the object.
+     *
+     * @param[in] object path to D-Bus object
+     * @param[in] interface interface name
+     * @param[in] check properties check function
+     */
+    void expectChange(const std::string& object, const char* interface,
+                      Check check);
+
+    /**
+     * @brief Expect new object with path started with specified prefix.
+     *
+     * @param[in] prefix object path prefix
+     * @param[in] interface interface name
+     * @param[in] check properties check function
+     */
+    void expectObject(const std::string& prefix, const char* interface,
+                      Check check);
+
+    /**
+     * @brief Expect removing of the object.
+     *
+     * @param[in] object path to D-Bus object
+     */
+    void expectRemoval(const std::string& object);
+
+    /**
+     * @brief Wait for the expected change and print the time it took.
+     *        Does nothing if waiting is disabled.
+     *
+     * @throw std::runtime_error on timeout
+     */
+    void wait();
+
+    /**
+     * @brief Create check function for property value.
+     *
+     * @param[in] name property name
+     * @param[in] value expected value
+     *
+     * @return check function
+     */
+    static Check equals(const char* name, const Dbus::PropertyValue& value);
+
+  private:
+    /** @brief InterfacesAdded signal handler. */
+    void interfacesAdded(sdbusplus::message::message& msg,
+                         const std::string& prefix, bool exact,
+                         const char* interface, const Check& check);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief D-Bus connection. */
+    Dbus& bus;
+    /** @brief Max time to wait, zero if waiting is disabled. */
+    std::chrono::seconds timeout;
+    /** @brief Time point of the request. */
+    Clock::time_point start;
+    /** @brief Flag: expected change has been detected. */
+    bool applied;
+    /** @brief Signal subscriptions. */
+    std::vector<sdbusplus::bus::match::match> matches;
+};
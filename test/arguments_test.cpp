@@ -2,6 +2,9 @@
 // Copyright (C) 2020 YADRO
 
 #include "arguments.hpp"
+#include "fqdn_regex.hpp"
+
+#include <random>
 
 #include <gtest/gtest.h>
 
@@ -47,6 +50,40 @@ TEST(ArgumentsTest, Numeric)
     ASSERT_THROW(args.asNumber(), std::invalid_argument);
 }
 
+TEST(ArgumentsTest, Ranges)
+{
+    using Ranges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    char* testArgs[] = {const_cast<char*>("100"),
+                        const_cast<char*>("100-199,300,305-310"),
+                        const_cast<char*>("305-310,100-199,300"),
+                        const_cast<char*>("5-9,1-3,4,7-12,12"),
+                        const_cast<char*>("0-4294967295"),
+                        const_cast<char*>(""),
+                        const_cast<char*>("1,"),
+                        const_cast<char*>(",1"),
+                        const_cast<char*>("1-"),
+                        const_cast<char*>("-1"),
+                        const_cast<char*>("5-3"),
+                        const_cast<char*>("1--3"),
+                        const_cast<char*>("1,,3"),
+                        const_cast<char*>("4294967296"),
+                        const_cast<char*>("0x10")};
+    const int argsNum = sizeof(testArgs) / sizeof(testArgs[0]);
+
+    Arguments args(argsNum, testArgs);
+
+    EXPECT_EQ(args.asRanges(), Ranges({{100, 100}}));
+    EXPECT_EQ(args.asRanges(), Ranges({{100, 199}, {300, 300}, {305, 310}}));
+    EXPECT_EQ(args.asRanges(), Ranges({{100, 199}, {300, 300}, {305, 310}}));
+    EXPECT_EQ(args.asRanges(), Ranges({{1, 12}}));
+    EXPECT_EQ(args.asRanges(), Ranges({{0, 4294967295}}));
+    while (args.peek())
+    {
+        ASSERT_THROW(args.asRanges(), std::invalid_argument);
+    }
+}
+
 TEST(ArgumentsTest, Action)
 {
     char* testArgs[] = {const_cast<char*>("add"), const_cast<char*>("del"),
@@ -115,16 +152,16 @@ TEST(ArgumentsTest, IpAddress)
 
     Arguments args(argsNum, testArgs);
 
-    EXPECT_EQ(args.asIpAddress(), std::make_tuple(IpVer::v4, testArgs[0]));
+    EXPECT_EQ(args.asIpAddress().str(), testArgs[0]);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
-    EXPECT_EQ(args.asIpAddress(), std::make_tuple(IpVer::v6, testArgs[5]));
+    EXPECT_EQ(args.asIpAddress().str(), testArgs[5]);
     // NOTE: Next test checks that zeroed words are truncated.
     //       So, the same index using in testArgs[] is not a mistype.
-    EXPECT_EQ(args.asIpAddress(), std::make_tuple(IpVer::v6, testArgs[5]));
-    EXPECT_EQ(args.asIpAddress(), std::make_tuple(IpVer::v6, testArgs[7]));
+    EXPECT_EQ(args.asIpAddress().str(), testArgs[5]);
+    EXPECT_EQ(args.asIpAddress().str(), testArgs[7]);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddress(), std::invalid_argument);
 }
@@ -145,16 +182,18 @@ TEST(ArgumentsTest, IpAddrMask)
 
     Arguments args(argsNum, testArgs);
 
-    EXPECT_EQ(args.asIpAddrMask(), std::make_tuple(IpVer::v4, "127.0.0.1", 8));
+    EXPECT_EQ(args.asIpAddrMask(),
+              std::make_tuple(*IpAddr::parse("127.0.0.1"), 8));
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
-    EXPECT_EQ(args.asIpAddrMask(), std::make_tuple(IpVer::v4, "127.0.0.1", 24));
+    EXPECT_EQ(args.asIpAddrMask(),
+              std::make_tuple(*IpAddr::parse("127.0.0.1"), 24));
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
     EXPECT_EQ(args.asIpAddrMask(),
-              std::make_tuple(IpVer::v6, "2001:db8:a::123", 64));
+              std::make_tuple(*IpAddr::parse("2001:db8:a::123"), 64));
     EXPECT_EQ(args.asIpAddrMask(),
-              std::make_tuple(IpVer::v6, "2001:db8:a::123", 64));
+              std::make_tuple(*IpAddr::parse("2001:db8:a::123"), 64));
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
     ASSERT_THROW(args.asIpAddrMask(), std::invalid_argument);
 }
@@ -344,3 +383,130 @@ TEST(ArgumentsTest, AddrAndPortNegative)
     ASSERT_THROW(args.parseAddrAndPort(), std::invalid_argument);
     args.asText();
 }
+
+TEST(ArgumentsTest, Option)
+{
+    char* testArgs[] = {const_cast<char*>("one"), const_cast<char*>("--wait"),
+                        const_cast<char*>("two"),
+                        const_cast<char*>("--timeout=5"),
+                        const_cast<char*>("--waiting")};
+    const int argsNum = sizeof(testArgs) / sizeof(testArgs[0]);
+
+    Arguments args(argsNum, testArgs);
+
+    EXPECT_STREQ(args.asText(), "one");
+    EXPECT_EQ(args.takeOption("--wait"), std::string());
+    EXPECT_EQ(args.takeOption("--wait"), std::nullopt);
+    EXPECT_EQ(args.takeOption("--timeout"), std::string("5"));
+    EXPECT_EQ(args.takeOption("--time"), std::nullopt);
+    EXPECT_STREQ(args.asText(), "two");
+    EXPECT_STREQ(args.asText(), "--waiting");
+    args.expectEnd();
+}
+
+TEST(ArgumentsTest, FQDN)
+{
+    static_assert(Arguments::isFQDN("a"));
+    static_assert(Arguments::isFQDN("a."));
+    static_assert(Arguments::isFQDN("Foo-Bar.COM"));
+    static_assert(Arguments::isFQDN("1.2.3.4.com"));
+    static_assert(!Arguments::isFQDN(""));
+    static_assert(!Arguments::isFQDN("."));
+    static_assert(!Arguments::isFQDN("a.."));
+    static_assert(!Arguments::isFQDN("a..com"));
+    static_assert(!Arguments::isFQDN("123"));
+    static_assert(!Arguments::isFQDN("a.1com"));
+    static_assert(!Arguments::isFQDN("a-.com"));
+    static_assert(!Arguments::isFQDN("a.-com"));
+    static_assert(!Arguments::isFQDN("foo_bar.com"));
+
+    // Length limits: 63 octets per label, 127 labels, 255 octets in total
+    const std::string label63(63, 'a');
+    EXPECT_TRUE(Arguments::isFQDN(label63));
+    EXPECT_FALSE(Arguments::isFQDN(label63 + 'a'));
+
+    std::string labels127;
+    for (int i = 0; i < 127; ++i)
+    {
+        labels127 += i ? ".a" : "a";
+    }
+    EXPECT_TRUE(Arguments::isFQDN(labels127));
+    EXPECT_TRUE(Arguments::isFQDN(labels127 + '.'));
+    EXPECT_FALSE(Arguments::isFQDN(labels127 + ".a"));
+
+    std::string name255 = label63 + '.' + label63 + '.' + label63 + '.';
+    name255 += std::string(255 - name255.size(), 'a');
+    EXPECT_TRUE(Arguments::isFQDN(name255));
+    EXPECT_FALSE(Arguments::isFQDN(name255 + '.'));
+}
+
+TEST(ArgumentsTest, FQDNRegexEquivalence)
+{
+    std::mt19937 rnd(1);
+
+    // Random short strings over the alphabet that matters for the validator
+    static const char alphabet[] = "aZ09-._\xc3";
+    std::uniform_int_distribution<size_t> symbol(0, sizeof(alphabet) - 2);
+    std::uniform_int_distribution<size_t> shortLen(0, 16);
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string name(shortLen(rnd), 0);
+        for (auto& c : name)
+        {
+            c = alphabet[symbol(rnd)];
+        }
+        ASSERT_EQ(Arguments::isFQDN(name), isFQDNRegex(name)) << name;
+    }
+
+    // Random names close to the length limits, half of them with a single
+    // defect inserted at random position
+    static const char edges[] = "aZ0";
+    static const char defects[] = "-_.";
+    std::uniform_int_distribution<size_t> edge(0, sizeof(edges) - 2);
+    std::uniform_int_distribution<size_t> defect(0, sizeof(defects) - 2);
+    std::uniform_int_distribution<size_t> labelsNum(1, 130);
+    std::uniform_int_distribution<size_t> longLabel(1, 65);
+    std::uniform_int_distribution<size_t> shortLabel(1, 3);
+    std::uniform_int_distribution<int> dots(0, 2);
+    std::bernoulli_distribution damage(0.5);
+    for (int i = 0; i < 200; ++i)
+    {
+        std::string name;
+        const size_t num = labelsNum(rnd);
+        const bool longLabels = num < 8;
+        for (size_t l = 0; l < num; ++l)
+        {
+            if (l)
+            {
+                name += '.';
+            }
+            std::string label(longLabels ? longLabel(rnd) : shortLabel(rnd),
+                              'x');
+            label.front() = edges[edge(rnd)];
+            label.back() = edges[edge(rnd)];
+            name += label;
+        }
+        name.append(dots(rnd), '.');
+        if (damage(rnd))
+        {
+            std::uniform_int_distribution<size_t> pos(0, name.size() - 1);
+            name[pos(rnd)] = defects[defect(rnd)];
+        }
+        ASSERT_EQ(Arguments::isFQDN(name), isFQDNRegex(name)) << name;
+    }
+}
+
+TEST(ArgumentsTest, NetInterface)
+{
+    char* testArgs[] = {const_cast<char*>("lo"),
+                        const_cast<char*>("nonexistent0"),
+                        const_cast<char*>("lo")};
+    const int argsNum = sizeof(testArgs) / sizeof(testArgs[0]);
+
+    Arguments args(argsNum, testArgs);
+
+    EXPECT_STREQ(args.asNetInterface(), "lo");
+    ASSERT_THROW(args.asNetInterface(), std::invalid_argument);
+    EXPECT_STREQ(args.asNetInterface(), "lo");
+    args.expectEnd();
+}
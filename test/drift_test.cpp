@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "drift.hpp"
+
+#include <gtest/gtest.h>
+
+/**
+ * @brief Add network interface object.
+ *
+ * @param[out] objects network objects
+ * @param[in] name network interface name
+ * @param[in] mac MAC address
+ * @param[in] vlan VLAN Id, 0 if not a VLAN
+ */
+static void addIface(Dbus::ManagedObject& objects, const char* name,
+                     const char* mac, uint32_t vlan = 0)
+{
+    auto& eth =
+        objects[sdbusplus::message::object_path(Dbus::ethToPath(name))];
+    eth[Dbus::ethInterface][Dbus::ethName] = std::string(name);
+    eth[Dbus::macInterface][Dbus::macSet] = std::string(mac);
+    if (vlan)
+    {
+        eth[Dbus::vlanInterface][Dbus::vlanId] = vlan;
+    }
+}
+
+/**
+ * @brief Add IP address object.
+ *
+ * @param[out] objects network objects
+ * @param[in] name network interface name
+ * @param[in] id object Id
+ * @param[in] address IP address
+ * @param[in] prefix prefix length
+ */
+static void addIp(Dbus::ManagedObject& objects, const char* name,
+                  const char* id, const char* address, uint8_t prefix)
+{
+    auto& ip = objects[sdbusplus::message::object_path(
+        Dbus::ethToPath(name) + "/ipv4/" + id)];
+    ip[Dbus::ipInterface][Dbus::ipAddress] = std::string(address);
+    ip[Dbus::ipInterface][Dbus::ipPrefix] = prefix;
+    ip[Dbus::ipInterface][Dbus::ipGateway] = std::string();
+}
+
+/**
+ * @brief Compare drift entry with expected values.
+ *
+ * @param[in] drift found difference
+ * @param[in] iface network interface name
+ * @param[in] field differing field
+ * @param[in] dbus value seen by the network service
+ * @param[in] kernel value programmed in the kernel
+ */
+static void expectDrift(const Drift& drift, const char* iface,
+                        const char* field, const char* dbus,
+                        const char* kernel)
+{
+    EXPECT_EQ(drift.iface, iface);
+    EXPECT_STREQ(drift.field, field);
+    EXPECT_EQ(drift.dbus, dbus);
+    EXPECT_EQ(drift.kernel, kernel);
+}
+
+TEST(DriftTest, NoDrift)
+{
+    Dbus::ManagedObject dbus;
+    addIface(dbus, "eth0", "02:00:00:00:00:0A");
+    addIp(dbus, "eth0", "1", "192.0.2.10", 24);
+    addIface(dbus, "eth0.100", "02:00:00:00:00:0a", 100);
+
+    // MAC differs only in case
+    Dbus::ManagedObject kernel;
+    addIface(kernel, "eth0", "02:00:00:00:00:0a");
+    addIp(kernel, "eth0", "a", "192.0.2.10", 24);
+    addIface(kernel, "eth0.100", "02:00:00:00:00:0a", 100);
+
+    EXPECT_TRUE(findDrift(dbus, kernel).empty());
+    EXPECT_TRUE(findDrift({}, {}).empty());
+}
+
+TEST(DriftTest, Interfaces)
+{
+    Dbus::ManagedObject dbus;
+    addIface(dbus, "eth0", "02:00:00:00:00:0a");
+    addIface(dbus, "eth0.100", "02:00:00:00:00:0a", 100);
+    addIface(dbus, "eth1", "02:00:00:00:00:0b");
+
+    Dbus::ManagedObject kernel;
+    addIface(kernel, "eth0", "02:00:00:00:00:0c");
+    addIface(kernel, "eth0.100", "02:00:00:00:00:0a", 101);
+    addIface(kernel, "eth2", "02:00:00:00:00:0d");
+
+    const auto drift = findDrift(dbus, kernel);
+    ASSERT_EQ(drift.size(), 4);
+    expectDrift(drift[0], "eth0", "mac", "02:00:00:00:00:0a",
+                "02:00:00:00:00:0c");
+    expectDrift(drift[1], "eth0.100", "vlan", "100", "101");
+    expectDrift(drift[2], "eth1", "interface", "present", "");
+    expectDrift(drift[3], "eth2", "interface", "", "present");
+
+    // Interface is not a VLAN for the network service
+    Dbus::ManagedObject plain;
+    addIface(plain, "eth0.100", "02:00:00:00:00:0a");
+    const auto vlan = findDrift(plain, kernel);
+    ASSERT_EQ(vlan.size(), 3);
+    expectDrift(vlan[0], "eth0", "interface", "", "present");
+    expectDrift(vlan[1], "eth0.100", "vlan", "", "101");
+}
+
+TEST(DriftTest, Addresses)
+{
+    Dbus::ManagedObject dbus;
+    addIface(dbus, "eth0", "02:00:00:00:00:0a");
+    addIp(dbus, "eth0", "1", "192.0.2.10", 24);
+    addIp(dbus, "eth0", "2", "192.0.2.11", 24);
+    addIp(dbus, "eth0", "3", "192.0.2.12", 24);
+
+    Dbus::ManagedObject kernel;
+    addIface(kernel, "eth0", "02:00:00:00:00:0a");
+    addIp(kernel, "eth0", "1", "192.0.2.10", 24);
+    addIp(kernel, "eth0", "2", "192.0.2.11", 25);
+    addIp(kernel, "eth0", "4", "192.0.2.13", 24);
+
+    const auto drift = findDrift(dbus, kernel);
+    ASSERT_EQ(drift.size(), 3);
+    expectDrift(drift[0], "eth0", "ip", "192.0.2.11/24", "192.0.2.11/25");
+    expectDrift(drift[1], "eth0", "ip", "192.0.2.12/24", "");
+    expectDrift(drift[2], "eth0", "ip", "", "192.0.2.13/24");
+}
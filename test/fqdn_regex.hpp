@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <regex>
+#include <string>
+
+/**
+ * @brief Check for FQDN format with the regular expression previously used
+ *        by Arguments::asIpOrFQDN. Reference for Arguments::isFQDN.
+ *
+ * @param[in] name value to check
+ *
+ * @return false if checked value is not a domain name
+ */
+inline bool isFQDNRegex(const std::string& name)
+{
+    static const std::regex r(
+        // According to RFC2181:
+        // A full domain name is limited to 255 octets
+        // (including separators),
+        "(?=^.{1,255}$)"
+        "(^"
+        // - The length of any single label is limited to 63 octets.
+        // - labels must not start or end with hyphens.
+        // According to RFC1123 (section 2.1):
+        // "...a segment of a host domain name is now allowed
+        // to begin with a digit and could legally be entirely numeric".
+        // - Total number of labels is limited to 127
+        "((?!-)[a-z0-9-]{0,62}[a-z0-9]\\.){0,126}"
+        // Trailing dot is optional.
+        // According to RFC1738 (section 3.1):
+        // "The rightmost domain label will never start with a digit".
+        "((?![0-9-])[a-z0-9-]{0,62}[a-z0-9]\\.?)"
+        "$)",
+        std::regex_constants::icase);
+
+    return std::regex_match(name, r);
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "ipaddr.hpp"
+
+#include <arpa/inet.h>
+
+#include <random>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+TEST(IpAddrTest, Parse)
+{
+    const auto ip4 = IpAddr::parse("192.168.1.1");
+    ASSERT_TRUE(ip4);
+    EXPECT_EQ(ip4->version(), IpVer::v4);
+    EXPECT_EQ(ip4->str(), "192.168.1.1");
+
+    const auto ip6 = IpAddr::parse("2001:DB8:0:0:0::1");
+    ASSERT_TRUE(ip6);
+    EXPECT_EQ(ip6->version(), IpVer::v6);
+    EXPECT_EQ(ip6->str(), "2001:db8::1");
+
+    EXPECT_FALSE(IpAddr::parse(""));
+    EXPECT_FALSE(IpAddr::parse("1.2.3"));
+    EXPECT_FALSE(IpAddr::parse("1.2.3.256"));
+    EXPECT_FALSE(IpAddr::parse("1:2:3:4:5:6:7:8:9"));
+    EXPECT_FALSE(IpAddr::parse("a.com"));
+}
+
+TEST(IpAddrTest, Format)
+{
+    const char* addrs[] = {
+        "0.0.0.0",       "255.255.255.255", "::",        "::1",
+        "1::",           "1:0:0:2::3",      "1::2:0:0:3", "1:0:2:0:3:0:4:0",
+        "::1.2.3.4",     "::ffff:1.2.3.4",  "::fffe:1.2.3.4",
+        "0:0:0:0:0:0:0:1", "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+    };
+    for (const char* text : addrs)
+    {
+        const auto ip = IpAddr::parse(text);
+        ASSERT_TRUE(ip) << text;
+
+        const int family = ip->version() == IpVer::v4 ? AF_INET : AF_INET6;
+        char expect[INET6_ADDRSTRLEN];
+        ASSERT_TRUE(inet_ntop(family, ip->data(), expect, sizeof(expect)));
+        EXPECT_EQ(ip->str(), expect);
+    }
+}
+
+TEST(IpAddrTest, FormatRandom)
+{
+    // Random IPv6 addresses with many zero words, compared with inet_ntop()
+    std::mt19937 rnd(1);
+    std::uniform_int_distribution<int> word(0, 0xffff);
+    std::uniform_int_distribution<int> kind(0, 3);
+    for (int i = 0; i < 100000; ++i)
+    {
+        uint8_t addr[16];
+        for (size_t w = 0; w < 8; ++w)
+        {
+            const int k = kind(rnd);
+            const uint16_t val = k < 2 ? 0 : (k == 2 ? 0xffff : word(rnd));
+            addr[w * 2] = static_cast<uint8_t>(val >> 8);
+            addr[w * 2 + 1] = static_cast<uint8_t>(val);
+        }
+
+        char text[INET6_ADDRSTRLEN];
+        ASSERT_TRUE(inet_ntop(AF_INET6, addr, text, sizeof(text)));
+        const auto ip = IpAddr::parse(text);
+        ASSERT_TRUE(ip) << text;
+        ASSERT_EQ(memcmp(ip->data(), addr, sizeof(addr)), 0) << text;
+        ASSERT_EQ(ip->str(), text);
+    }
+}
+
+TEST(IpAddrTest, Compare)
+{
+    const IpAddr a = *IpAddr::parse("10.0.0.1");
+    const IpAddr b = *IpAddr::parse("10.0.0.2");
+    const IpAddr c = *IpAddr::parse("::a00:1");
+
+    EXPECT_EQ(a, *IpAddr::parse("10.0.0.1"));
+    EXPECT_NE(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_LT(a, b);
+    EXPECT_LT(b, c);
+
+    const std::unordered_set<IpAddr> set = {a, b, c, a};
+    EXPECT_EQ(set.size(), 3);
+    EXPECT_EQ(set.count(*IpAddr::parse("10.0.0.2")), 1);
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "json.hpp"
+
+#include <cstdlib>
+#include <functional>
+
+#include <gtest/gtest.h>
+
+/**
+ * @brief Run the writer and capture its output.
+ *
+ * @param[in] fn function producing JSON
+ *
+ * @return output text
+ */
+static std::string capture(const std::function<void(JsonWriter&)>& fn)
+{
+    char* buf = nullptr;
+    size_t size = 0;
+    FILE* out = open_memstream(&buf, &size);
+    JsonWriter json(out);
+    fn(json);
+    fclose(out);
+    std::string text(buf, size);
+    free(buf);
+    return text;
+}
+
+TEST(JsonTest, Scalars)
+{
+    EXPECT_EQ(capture([](JsonWriter& json) { json.string("text"); }),
+              "\"text\"");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.number(0); }), "0");
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.number(18446744073709551615ull);
+              }),
+              "18446744073709551615");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.boolean(true); }), "true");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.boolean(false); }),
+              "false");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.null(); }), "null");
+}
+
+TEST(JsonTest, Escape)
+{
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.string("a\"b\\c\nd\re\tf\x01g\x1fh");
+              }),
+              "\"a\\\"b\\\\c\\nd\\re\\tf\\u0001g\\u001fh\"");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.string("\xd0\xaf"); }),
+              "\"\xd0\xaf\"");
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.string(std::string_view("a\0b", 3));
+              }),
+              "\"a\\u0000b\"");
+}
+
+TEST(JsonTest, Containers)
+{
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.beginObject().endObject();
+              }),
+              "{}");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.strings({}); }), "[]");
+    EXPECT_EQ(capture([](JsonWriter& json) { json.strings({"a", "b"}); }),
+              "[\"a\",\"b\"]");
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.beginObject();
+                  json.key("str").string("val");
+                  json.key("num").number(42);
+                  json.key("list").beginArray();
+                  json.beginObject().key("x").null().endObject();
+                  json.beginObject().endObject();
+                  json.endArray();
+                  json.key("flag").boolean(false);
+                  json.endObject();
+              }),
+              "{\"str\":\"val\",\"num\":42,\"list\":[{\"x\":null},{}],"
+              "\"flag\":false}");
+}
+
+TEST(JsonTest, Lines)
+{
+    EXPECT_EQ(capture([](JsonWriter& json) {
+                  json.beginObject().key("a").number(1).endObject();
+                  json.endLine();
+                  json.beginObject().key("b").number(2).endObject();
+                  json.endLine();
+              }),
+              "{\"a\":1}\n{\"b\":2}\n");
+}
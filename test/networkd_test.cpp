@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "networkd.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+/**
+ * @class NetworkdTest
+ * @brief Configuration directory with a single interface in a temporary
+ *        directory.
+ */
+class NetworkdTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/networkd_test.XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl));
+        dir = tmpl;
+        write("00-bmc-eth0.network", "[Match]\n"
+                                     "Name=eth0\n"
+                                     "[Network]\n"
+                                     "DHCP=false\n"
+                                     "DNS=192.0.2.53\n"
+                                     "Gateway=192.0.2.1\n"
+                                     "[Address]\n"
+                                     "Address=192.0.2.10/24\n"
+                                     "[DHCP]\n"
+                                     "UseDNS=false\n");
+    }
+
+    void TearDown() override
+    {
+        const std::string cmd = "rm -rf " + dir;
+        ASSERT_EQ(system(cmd.c_str()), 0);
+    }
+
+    void write(const char* name, const char* content)
+    {
+        std::ofstream(dir + '/' + name) << content;
+    }
+
+    std::string read(const char* name)
+    {
+        std::stringstream content;
+        content << std::ifstream(dir + '/' + name).rdbuf();
+        return content.str();
+    }
+
+    Networkd networkd()
+    {
+        hostname = dir + "/hostname";
+        return Networkd(dir.c_str(), hostname.c_str());
+    }
+
+    std::string dir;
+    std::string hostname;
+};
+
+TEST(UnitFileTest, Parse)
+{
+    UnitFile file;
+    file.parse("# comment\n"
+               "[Network]\n"
+               " DNS = 192.0.2.1 192.0.2.2 \n"
+               "DNS=\n"
+               "DNS=192.0.2.3\n"
+               "NTP=ntp.example.com\n"
+               "[Address]\n"
+               "Address=192.0.2.10/24\n"
+               "[Address]\n"
+               "Address=192.0.2.11/24\n");
+
+    EXPECT_EQ(file.getList("Network", "DNS"),
+              std::vector<std::string>({"192.0.2.3"}));
+    EXPECT_EQ(file.get("Network", "NTP"), "ntp.example.com");
+    EXPECT_FALSE(file.get("Network", "DHCP"));
+    EXPECT_EQ(file.getList("Address", "Address"),
+              std::vector<std::string>({"192.0.2.10/24", "192.0.2.11/24"}));
+
+    EXPECT_EQ(file.remove("Address", "Address", "192.0.2.10/24"), 1);
+    file.set("Network", "DNS", {});
+    file.set("Link", "MACAddress", {"02:00:00:00:00:01"});
+    EXPECT_EQ(file.str(), "[Network]\n"
+                          "NTP=ntp.example.com\n"
+                          "\n"
+                          "[Address]\n"
+                          "Address=192.0.2.11/24\n"
+                          "\n"
+                          "[Link]\n"
+                          "MACAddress=02:00:00:00:00:01\n");
+
+    EXPECT_THROW(file.parse("Name=eth0\n"), std::invalid_argument);
+    EXPECT_THROW(file.parse("[Match]\nName\n"), std::invalid_argument);
+}
+
+TEST_F(NetworkdTest, Addresses)
+{
+    const Networkd cfg = networkd();
+    using Addresses = std::vector<std::tuple<IpAddr, uint8_t>>;
+    const auto v4 = [](const char* ip, uint8_t mask) {
+        return std::make_tuple(*IpAddr::parse(ip), mask);
+    };
+
+    cfg.editAddresses("eth0", {}, {v4("192.0.2.11", 24)});
+    EXPECT_EQ(cfg.getAddresses("eth0"),
+              Addresses({v4("192.0.2.10", 24), v4("192.0.2.11", 24)}));
+
+    // Nothing is written if any of the addresses is wrong
+    EXPECT_THROW(cfg.editAddresses("eth0", {}, {v4("192.0.2.11", 24)}),
+                 std::invalid_argument);
+    EXPECT_THROW(cfg.editAddresses("eth0", {*IpAddr::parse("192.0.2.12")},
+                                   {v4("192.0.2.13", 24)}),
+                 std::invalid_argument);
+    EXPECT_THROW(cfg.getAddresses("eth1"), std::invalid_argument);
+
+    cfg.editAddresses("eth0", {*IpAddr::parse("192.0.2.10")},
+                      {v4("192.0.2.10", 25)});
+    EXPECT_EQ(cfg.getAddresses("eth0"),
+              Addresses({v4("192.0.2.11", 24), v4("192.0.2.10", 25)}));
+}
+
+TEST_F(NetworkdTest, Gateway)
+{
+    const Networkd cfg = networkd();
+    EXPECT_THROW(cfg.setGateway(*IpAddr::parse("198.51.100.1")),
+                 std::runtime_error);
+
+    cfg.setGateway(*IpAddr::parse("192.0.2.254"));
+    const auto objects = cfg.getObjects();
+    const auto& syscfg =
+        objects.at(sdbusplus::message::object_path(Dbus::objectConfig))
+            .at(Dbus::syscfgInterface);
+    EXPECT_EQ(std::get<std::string>(syscfg.at(Dbus::syscfgDefGw4)),
+              "192.0.2.254");
+}
+
+TEST_F(NetworkdTest, Vlans)
+{
+    const Networkd cfg = networkd();
+    EXPECT_EQ(cfg.addVlans("eth0", {100, 101}), 2);
+    EXPECT_EQ(cfg.addVlans("eth0", {101, 102}), 1);
+    EXPECT_EQ(read("00-bmc-eth0.100.netdev"), "[NetDev]\n"
+                                              "Name=eth0.100\n"
+                                              "Kind=vlan\n"
+                                              "\n"
+                                              "[VLAN]\n"
+                                              "Id=100\n");
+
+    const auto objects = cfg.getObjects();
+    const auto& vlan =
+        objects.at(sdbusplus::message::object_path(Dbus::ethToPath("eth0.101")))
+            .at(Dbus::vlanInterface);
+    EXPECT_EQ(std::get<uint32_t>(vlan.at(Dbus::vlanId)), 101);
+
+    EXPECT_EQ(cfg.removeVlans("eth0", {100, 101, 103}), 2);
+    EXPECT_EQ(access((dir + "/00-bmc-eth0.100.netdev").c_str(), F_OK), -1);
+    UnitFile parent;
+    ASSERT_TRUE(parent.load(dir + "/00-bmc-eth0.network"));
+    EXPECT_EQ(parent.getList("Network", "VLAN"),
+              std::vector<std::string>({"eth0.102"}));
+}
+
+TEST_F(NetworkdTest, Objects)
+{
+    const Networkd cfg = networkd();
+    cfg.setHostname("bmc");
+    cfg.setDhcp("eth0", true);
+    cfg.setServers("eth0", "NTP", {"ntp1.example.com", "ntp2.example.com"});
+
+    const auto objects = cfg.getObjects();
+    const auto& syscfg =
+        objects.at(sdbusplus::message::object_path(Dbus::objectConfig))
+            .at(Dbus::syscfgInterface);
+    EXPECT_EQ(std::get<std::string>(syscfg.at(Dbus::syscfgHostname)), "bmc");
+
+    const std::string path = Dbus::ethToPath("eth0");
+    const auto& eth = objects.at(sdbusplus::message::object_path(path))
+                          .at(Dbus::ethInterface);
+    EXPECT_EQ(std::get<std::string>(eth.at(Dbus::ethDhcpEnabled)),
+              "xyz.openbmc_project.Network.EthernetInterface.DHCPConf.both");
+    EXPECT_EQ(std::get<std::vector<std::string>>(eth.at(Dbus::ethNtpServers)),
+              std::vector<std::string>(
+                  {"ntp1.example.com", "ntp2.example.com"}));
+    EXPECT_EQ(
+        std::get<std::vector<std::string>>(eth.at(Dbus::ethStNameServers)),
+        std::vector<std::string>({"192.0.2.53"}));
+
+    const auto addresses = Dbus::getAddresses(path.c_str(), objects);
+    ASSERT_EQ(addresses.size(), 1);
+    EXPECT_EQ(addresses.front().address.str(), "192.0.2.10");
+    EXPECT_EQ(addresses.front().mask, 24);
+}
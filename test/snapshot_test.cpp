@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+/**
+ * @brief Build objects tree with all value types.
+ *
+ * @return network objects
+ */
+static Dbus::ManagedObject sampleObjects()
+{
+    Dbus::ManagedObject objects;
+    auto& eth = objects[sdbusplus::message::object_path(
+        "/xyz/openbmc_project/network/eth0")];
+    eth[Dbus::ethInterface][Dbus::ethName] = std::string("eth0");
+    eth[Dbus::ethInterface][Dbus::ethLinkUp] = true;
+    eth[Dbus::ethInterface][Dbus::ethSpeed] = uint32_t(1000);
+    eth[Dbus::ethInterface][Dbus::ethNameServers] =
+        std::vector<std::string>{"192.0.2.1", "192.0.2.2"};
+    eth[Dbus::ethInterface][Dbus::ethNtpServers] = std::vector<std::string>();
+    eth[Dbus::vlanInterface][Dbus::vlanId] = uint16_t(100);
+    auto& ip = objects[sdbusplus::message::object_path(
+        "/xyz/openbmc_project/network/eth0/ipv4/1")];
+    ip[Dbus::ipInterface][Dbus::ipAddress] = std::string("192.0.2.10");
+    ip[Dbus::ipInterface][Dbus::ipPrefix] = uint8_t(24);
+    ip[Dbus::ipInterface][Dbus::ipGateway] = std::string();
+    return objects;
+}
+
+/**
+ * @class SnapshotTest
+ * @brief Snapshot file in a temporary directory.
+ */
+class SnapshotTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/snapshot_test.XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl));
+        dir = tmpl;
+        path = dir + "/snapshot";
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+        rmdir(dir.c_str());
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+TEST(SnapshotCodecTest, RoundTrip)
+{
+    const Dbus::ManagedObject objects = sampleObjects();
+    std::string data;
+    Snapshot::encode(objects, data);
+
+    Dbus::ManagedObject decoded;
+    ASSERT_TRUE(Snapshot::decode(data, decoded));
+    EXPECT_EQ(decoded, objects);
+
+    ASSERT_TRUE(Snapshot::decode(std::string(4, '\0'), decoded));
+    EXPECT_TRUE(decoded.empty());
+}
+
+TEST(SnapshotCodecTest, Malformed)
+{
+    std::string data;
+    Snapshot::encode(sampleObjects(), data);
+
+    Dbus::ManagedObject decoded;
+    for (size_t len = 0; len < data.size(); ++len)
+    {
+        EXPECT_FALSE(Snapshot::decode(std::string_view(data.data(), len),
+                                      decoded))
+            << "length " << len;
+    }
+    EXPECT_FALSE(Snapshot::decode(data + '\0', decoded));
+
+    // Huge count must be rejected before allocating
+    const std::string huge("\xff\xff\xff\xff", 4);
+    EXPECT_FALSE(Snapshot::decode(huge, decoded));
+}
+
+TEST_F(SnapshotTest, PublishRead)
+{
+    EXPECT_FALSE(Snapshot::read(path.c_str()));
+
+    const Dbus::ManagedObject objects = sampleObjects();
+    {
+        Snapshot snapshot(path.c_str());
+        EXPECT_FALSE(Snapshot::read(path.c_str()));
+
+        snapshot.publish(objects);
+        const auto read = Snapshot::read(path.c_str());
+        ASSERT_TRUE(read);
+        EXPECT_EQ(*read, objects);
+
+        // Network service has gone
+        snapshot.publish(Dbus::ManagedObject());
+        EXPECT_FALSE(Snapshot::read(path.c_str()));
+
+        snapshot.publish(objects);
+        EXPECT_TRUE(Snapshot::read(path.c_str()));
+    }
+
+    // Publisher has exited
+    EXPECT_FALSE(Snapshot::read(path.c_str()));
+}
+
+TEST_F(SnapshotTest, InterruptedWrite)
+{
+    {
+        Snapshot snapshot(path.c_str());
+    }
+
+    // Publisher has died in the middle of write(): the sequence is odd,
+    // it follows signature, version and header size
+    uint32_t seq;
+    const int fd = open(path.c_str(), O_RDWR);
+    ASSERT_NE(fd, -1);
+    ASSERT_EQ(pread(fd, &seq, sizeof(seq), 8), sizeof(seq));
+    seq |= 1;
+    ASSERT_EQ(pwrite(fd, &seq, sizeof(seq), 8), sizeof(seq));
+    close(fd);
+
+    Snapshot snapshot(path.c_str());
+    snapshot.publish(sampleObjects());
+    EXPECT_TRUE(Snapshot::read(path.c_str()));
+}
+
+TEST_F(SnapshotTest, Untrusted)
+{
+    Snapshot snapshot(path.c_str());
+    snapshot.publish(sampleObjects());
+    ASSERT_TRUE(Snapshot::read(path.c_str()));
+
+    // Symbolic link may point to a file of another user
+    const std::string link = dir + "/link";
+    ASSERT_EQ(symlink(path.c_str(), link.c_str()), 0);
+    EXPECT_FALSE(Snapshot::read(link.c_str()));
+    unlink(link.c_str());
+
+    ASSERT_EQ(chmod(path.c_str(), 0666), 0);
+    EXPECT_FALSE(Snapshot::read(path.c_str()));
+}
+
+TEST_F(SnapshotTest, UnknownVersion)
+{
+    Snapshot snapshot(path.c_str());
+    snapshot.publish(sampleObjects());
+    ASSERT_TRUE(Snapshot::read(path.c_str()));
+
+    // Layout version follows the 4-byte signature
+    const uint16_t version = Snapshot::layoutVersion + 1;
+    const int fd = open(path.c_str(), O_WRONLY);
+    ASSERT_NE(fd, -1);
+    ASSERT_EQ(pwrite(fd, &version, sizeof(version), 4), sizeof(version));
+    close(fd);
+
+    EXPECT_FALSE(Snapshot::read(path.c_str()));
+}